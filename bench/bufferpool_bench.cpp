@@ -0,0 +1,69 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <thread>
+#include <vector>
+
+/**
+ * Buffer pool hit throughput as a function of thread count and shard count.
+ * Every thread looks up random pages of a working set that is fully resident, so the measured cost is the latch and
+ * the page table lookup of a hit.
+ */
+
+namespace {
+constexpr size_t NUM_PAGES = 4096;
+constexpr size_t WORKING_SET = 2048;
+constexpr size_t LOOKUPS_PER_THREAD = 1 << 20;
+
+double run(db::BufferPool &bufferPool, db::file_id_t file, size_t threads) {
+  std::atomic<bool> start{false};
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      uint64_t x = 0x9e3779b97f4a7c15ULL * (t + 1);
+      while (!start.load(std::memory_order_acquire))
+        ;
+      for (size_t i = 0; i < LOOKUPS_PER_THREAD; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        bufferPool.getPage({file, x % WORKING_SET});
+      }
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  start.store(true, std::memory_order_release);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return static_cast<double>(threads * LOOKUPS_PER_THREAD) / elapsed.count();
+}
+} // namespace
+
+int main() {
+  const std::string name = "bufferpool_bench.dat";
+  std::remove(name.c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::DbFile>(name, db::TupleDesc()));
+
+  size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> shard_counts{1, 4, 16, 64};
+  std::printf("%8s %8s %16s\n", "shards", "threads", "hits/s");
+  for (size_t shards : shard_counts) {
+    db.configureBufferPool({.num_pages = NUM_PAGES, .num_shards = shards});
+    db::BufferPool &bufferPool = db.getBufferPool();
+    for (size_t page = 0; page < WORKING_SET; page++) {
+      bufferPool.getPage({name, page});
+    }
+    for (size_t threads = 1; threads <= 2 * cores; threads *= 2) {
+      std::printf("%8zu %8zu %16.0f\n", shards, threads, run(bufferPool, db.get(name).getId(), threads));
+    }
+  }
+
+  db.remove(name);
+  std::remove(name.c_str());
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+
+/**
+ * Loading rows of (INT, DOUBLE) into an empty heap file, one insertTuple per row versus a HeapLoader. Both include
+ * writing the pages to the file: the inserted pages are flushed from the pool, the loaded pages are written in batches
+ * while loading. The rows are built before the timer starts.
+ */
+
+namespace {
+constexpr size_t ROWS = 4'000'000;
+
+const std::string file = "bulk_load_bench.dat";
+
+db::TupleDesc schema() { return {{db::type_t::INT, db::type_t::DOUBLE}, {"id", "value"}}; }
+
+void run(const char *label, const std::vector<db::Tuple> &rows, bool bulk) {
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  db.add(std::make_unique<db::HeapFile>(file, schema()));
+  auto &heap = dynamic_cast<db::HeapFile &>(db.get(file));
+
+  auto begin = std::chrono::steady_clock::now();
+  if (bulk) {
+    heap.bulkLoad(rows);
+  } else {
+    for (const db::Tuple &row : rows) {
+      heap.insertTuple(row);
+    }
+    db.getBufferPool().flushFile(file);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  db::IoStats io = heap.getIoStats();
+  std::printf("%-8s %10zu %14.0f %10.1f %12zu\n", label, heap.getNumPages(), rows.size() / elapsed.count(),
+              io.bytes_written / elapsed.count() / (1 << 20), io.write_latency.count());
+  db.remove(file);
+}
+} // namespace
+
+int main() {
+  std::vector<db::Tuple> rows;
+  rows.reserve(ROWS);
+  for (size_t i = 0; i < ROWS; i++) {
+    rows.push_back({{static_cast<int>(i), 0.5 * static_cast<double>(i)}});
+  }
+
+  std::printf("%-8s %10s %14s %10s %12s\n", "method", "pages", "rows/s", "MiB/s", "writes");
+  run("insert", rows, false);
+  run("bulk", rows, true);
+
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  return 0;
+}
@@ -0,0 +1,146 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/Query.hpp>
+#include <new>
+
+/**
+ * The query operators over a resident heap file of CHAR-heavy rows (INT, CHAR, CHAR, CHAR) whose strings are longer
+ * than the small string buffer, so that every CHAR field copied into a std::string allocates. Filter keeps half of
+ * the rows, projection keeps two of the four columns, join matches every row of a 2000-row table with one row of
+ * another. Allocations are counted by replacing the global operator new and reported per output row, time per input
+ * row (per pair of rows for the join). The tuple rows deserialize every row of the file into a Tuple, materialize
+ * every row from its view, and copy resident Tuples.
+ */
+
+namespace {
+std::atomic<size_t> allocations = 0;
+
+constexpr size_t ROWS = 100'000;
+constexpr size_t JOIN_ROWS = 2000;
+
+db::TupleDesc schema(const std::string &prefix) {
+  return {{db::type_t::INT, db::type_t::CHAR, db::type_t::CHAR, db::type_t::CHAR},
+          {prefix + "id", prefix + "name", prefix + "city", prefix + "note"}};
+}
+
+db::HeapFile &create(const std::string &name, const db::TupleDesc &td) {
+  std::remove(name.c_str());
+  std::remove((name + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  return dynamic_cast<db::HeapFile &>(db.get(name));
+}
+
+void load(db::HeapFile &file, size_t rows) {
+  db::HeapLoader loader(file);
+  for (size_t i = 0; i < rows; i++) {
+    loader.append({{static_cast<int>(i), "name of row " + std::to_string(i) + " padded out",
+                    "a city with a long name", "a note that does not fit in the small string buffer"}});
+  }
+}
+
+template <typename F> void run(const char *label, size_t input_rows, const db::TupleDesc &out_td, F &&query) {
+  db::Database &db = db::getDatabase();
+  std::string name = "char_bench.out";
+  db::HeapFile &out = create(name, out_td);
+  size_t before = allocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  query(out);
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  size_t allocated = allocations.load() - before;
+  size_t output_rows = 0;
+  for (auto it = out.begin(); it != out.end(); ++it) {
+    output_rows++;
+  }
+  std::printf("%-12s %10zu %16.3f %12.1f\n", label, output_rows,
+              static_cast<double>(allocated) / static_cast<double>(output_rows), elapsed.count() / input_rows);
+  db.remove(name);
+  std::remove(name.c_str());
+  std::remove((name + ".fsm").c_str());
+}
+
+template <typename F> void measure(const char *label, size_t rows, F &&body) {
+  size_t before = allocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  size_t sum = body();
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  size_t allocated = allocations.load() - before;
+  std::printf("%-12s %10zu %16.3f %12.1f\n", label, rows, static_cast<double>(allocated) / static_cast<double>(rows),
+              elapsed.count() / rows);
+  // Keep the work from being optimized away
+  if (sum == 0) {
+    std::printf("-");
+  }
+}
+} // namespace
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+int main() {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = 16384, .scan_ring_pages = 0});
+  db::TupleDesc td = schema("");
+  db::HeapFile &heap = create("char_bench.dat", td);
+  load(heap, ROWS);
+  db::TupleDesc right_td = schema("r_");
+  db::HeapFile &left = create("char_bench.left", td);
+  load(left, JOIN_ROWS);
+  db::HeapFile &right = create("char_bench.right", right_td);
+  load(right, JOIN_ROWS);
+
+  std::printf("%-12s %10s %16s %12s\n", "operator", "rows out", "allocs/row out", "ns/row in");
+  run("filter", ROWS, td, [&](db::DbFile &out) { db::filter(heap, out, {{"id", db::PredicateOp::LT, int(ROWS / 2)}}); });
+  run("projection", ROWS, db::TupleDesc({db::type_t::CHAR, db::type_t::INT}, {"name", "id"}),
+      [&](db::DbFile &out) { db::projection(heap, out, {"name", "id"}); });
+  run("join", JOIN_ROWS * JOIN_ROWS, db::TupleDesc::merge(td, right_td),
+      [&](db::DbFile &out) { db::join(left, right, out, {"id", db::PredicateOp::EQ, "r_id"}); });
+
+  measure("deserialize", ROWS, [&] {
+    size_t sum = 0;
+    for (auto it = heap.begin(); it != heap.end(); ++it) {
+      db::Tuple t = *it;
+      sum += std::get<int>(t.get_field(0));
+    }
+    return sum;
+  });
+  measure("materialize", ROWS, [&] {
+    size_t sum = 0;
+    for (auto it = heap.begin(); it != heap.end(); ++it) {
+      sum += std::get<int>(it.view().materialize().get_field(0));
+    }
+    return sum;
+  });
+  std::vector<db::Tuple> tuples;
+  for (auto it = left.begin(); it != left.end(); ++it) {
+    tuples.push_back(*it);
+  }
+  measure("tuple copy", tuples.size(), [&] {
+    size_t sum = 0;
+    for (const db::Tuple &t : tuples) {
+      db::Tuple copy = t;
+      sum += copy.size();
+    }
+    return sum;
+  });
+
+  for (const char *name : {"char_bench.dat", "char_bench.left", "char_bench.right"}) {
+    db.remove(name);
+    std::remove(name);
+    std::remove((std::string(name) + ".fsm").c_str());
+  }
+  return 0;
+}
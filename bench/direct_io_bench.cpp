@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Memory footprint and throughput of random page reads with and without direct I/O, for a file 8x larger than the pool.
+ * Without direct I/O every page read is also kept in the page cache of the OS, so the memory used for the file grows
+ * to the whole file on top of the frames of the pool. RSS only counts the memory of the process, the cached pages of
+ * the file are counted with mincore.
+ */
+
+namespace {
+constexpr size_t NUM_PAGES = 2048;
+constexpr size_t FILE_PAGES = 8 * NUM_PAGES;
+constexpr size_t ACCESSES = 1 << 16;
+
+const std::string file = "direct_io_bench.dat";
+
+size_t rssKiB() {
+  FILE *status = std::fopen("/proc/self/status", "r");
+  char line[256];
+  size_t kib = 0;
+  while (std::fgets(line, sizeof(line), status)) {
+    if (std::strncmp(line, "VmRSS:", 6) == 0) {
+      std::sscanf(line + 6, "%zu", &kib);
+    }
+  }
+  std::fclose(status);
+  return kib;
+}
+
+/// Pages of the file in the page cache, or drops them if `drop` is set
+size_t cachedPages(bool drop) {
+  int fd = open(file.c_str(), O_RDONLY);
+  size_t bytes = FILE_PAGES * db::DEFAULT_PAGE_SIZE;
+  size_t count = 0;
+  if (drop) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  } else if (void *mem = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0); mem != MAP_FAILED) {
+    size_t os_page = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((bytes + os_page - 1) / os_page);
+    mincore(mem, bytes, resident.data());
+    for (unsigned char r : resident) {
+      count += r & 1;
+    }
+    munmap(mem, bytes);
+    count = count * os_page / db::DEFAULT_PAGE_SIZE;
+  }
+  close(fd);
+  return count;
+}
+
+void run(const char *label, bool direct_io) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = NUM_PAGES, .direct_io = direct_io});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  cachedPages(true);
+
+  std::mt19937_64 rng(42);
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ACCESSES; i++) {
+    bufferPool.getPage({file, rng() % FILE_PAGES});
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  std::printf("%10s %8s %14.0f %14zu %16zu\n", label, db.get(file).isDirectIo() ? "yes" : "no",
+              ACCESSES / elapsed.count(), rssKiB(), cachedPages(false) * db::DEFAULT_PAGE_SIZE / 1024);
+}
+} // namespace
+
+int main() {
+  std::remove(file.c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::DbFile>(file, db::TupleDesc()));
+  db.configureBufferPool({.num_pages = NUM_PAGES});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  for (size_t i = 0; i < FILE_PAGES; i++) {
+    bufferPool.getPage({file, i}).fill(static_cast<uint8_t>(i));
+    bufferPool.markDirty({file, i});
+  }
+  bufferPool.flushFile(file);
+
+  std::printf("%10s %8s %14s %14s %16s\n", "mode", "O_DIRECT", "accesses/s", "RSS KiB", "page cache KiB");
+  run("buffered", false);
+  run("direct", true);
+
+  db.remove(file);
+  std::remove(file.c_str());
+  return 0;
+}
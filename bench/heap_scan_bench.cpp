@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/HeapPage.hpp>
+
+/**
+ * Heap file scans over files of narrow tuples (a single INT, 992 slots per page) with different densities. The pool
+ * holds the whole file and a warm-up scan loads it, so the timed scans measure the slot search of HeapPage rather than
+ * I/O. Each file is scanned tuple by tuple with the Iterator, and a page at a time with DbFile::nextBatch, both
+ * reading the INT field of every tuple. Fill is the time to insert into empty in-memory pages until they are full,
+ * which searches for the first free slot on every insert.
+ */
+
+namespace {
+constexpr size_t FILE_PAGES = 2048;
+constexpr size_t FILL_PAGES = 64;
+constexpr size_t SCANS = 5;
+
+const std::string file = "heap_scan_bench.dat";
+
+db::TupleDesc schema() { return {{db::type_t::INT}, {"id"}}; }
+
+/**
+ * Writes a file in which one page out of `page_stride` holds tuples, every `slot_stride`-th slot of it.
+ */
+void build(size_t page_stride, size_t slot_stride) {
+  std::remove(file.c_str());
+  db::DbFile out(file, schema());
+  db::TupleDesc td = schema();
+  db::Page full{};
+  db::HeapPage hp(full, td);
+  while (hp.insertTuple({{0}})) {
+  }
+  db::Page page{};
+  for (size_t i = 0; i < FILE_PAGES; i++) {
+    page.fill(0);
+    if (i % page_stride == 0) {
+      // Copy the header of a full page and clear the unused slots
+      page = full;
+      db::HeapPage sparse(page, td);
+      for (size_t slot = sparse.begin(); slot != sparse.end(); sparse.next(slot)) {
+        if (slot % slot_stride != 0) {
+          sparse.deleteTuple(slot);
+        }
+      }
+    }
+    out.writePage(page, i);
+  }
+}
+
+void run(const char *label, size_t page_stride, size_t slot_stride) {
+  build(page_stride, slot_stride);
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = FILE_PAGES, .scan_ring_pages = 0});
+  db.add(std::make_unique<db::HeapFile>(file, schema()));
+  db::DbFile &heap = db.get(file);
+  for (auto it = heap.begin(); it != heap.end(); ++it) {
+  }
+
+  size_t tuples = 0;
+  long sum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    for (auto it = heap.begin(); it != heap.end(); ++it) {
+      sum += it.view().get_int(0);
+      tuples++;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+  size_t batched = 0;
+  db::PageBatch batch;
+  begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    for (auto it = heap.begin(); heap.nextBatch(it, batch);) {
+      for (size_t row = 0; row < batch.size(); row++) {
+        sum -= batch.view(row).get_int(0);
+      }
+      batched += batch.size();
+    }
+  }
+  batch.clear();
+  std::chrono::duration<double> batch_elapsed = std::chrono::steady_clock::now() - begin;
+  if (sum != 0 || batched != tuples) {
+    std::printf("batch scan mismatch\n");
+  }
+  std::printf("%-14s %10zu %14.0f %14.0f %14.0f\n", label, tuples / SCANS, tuples / elapsed.count(),
+              SCANS * FILE_PAGES / elapsed.count(), tuples / batch_elapsed.count());
+  db.remove(file);
+}
+
+void fill() {
+  db::TupleDesc td = schema();
+  db::Page page{};
+  size_t tuples = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < FILL_PAGES; i++) {
+    page.fill(0);
+    db::HeapPage hp(page, td);
+    while (hp.insertTuple({{static_cast<int>(tuples)}})) {
+      tuples++;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  std::printf("%-14s %10zu %14.0f %14.0f %14s\n", "fill", tuples / FILL_PAGES, tuples / elapsed.count(),
+              FILL_PAGES / elapsed.count(), "-");
+}
+} // namespace
+
+int main() {
+  std::printf("%-14s %10s %14s %14s %14s\n", "file", "tuples", "tuples/s", "pages/s", "batch tuples/s");
+  run("dense", 1, 1);
+  run("sparse", 1, 64);
+  run("one per page", 1, 1024);
+  run("mostly empty", 16, 1024);
+  fill();
+  std::remove(file.c_str());
+  return 0;
+}
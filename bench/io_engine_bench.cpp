@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <db/IoEngine.hpp>
+#include <db/types.hpp>
+#include <fcntl.h>
+#include <numeric>
+#include <random>
+#include <unistd.h>
+
+/**
+ * Page reads per second of each I/O engine at queue depths 1 to 64, for sequential and random page orders.
+ * Every batch of `depth` reads is submitted at once and completes before the next one is submitted.
+ */
+
+namespace {
+constexpr size_t FILE_PAGES = 16384;
+constexpr size_t READS = 1 << 15;
+
+const char *file = "io_engine_bench.dat";
+
+double run(db::IoEngine &engine, int fd, const std::vector<size_t> &order, size_t depth) {
+  std::vector<db::Page> pages(depth);
+  std::vector<db::IoRequest> batch;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < order.size(); i += depth) {
+    batch.clear();
+    for (size_t j = i; j < std::min(i + depth, order.size()); j++) {
+      batch.push_back({db::IoRequest::Op::READ, fd, pages[j - i].data(), db::DEFAULT_PAGE_SIZE,
+                       static_cast<off_t>(order[j] * db::DEFAULT_PAGE_SIZE)});
+    }
+    engine.submit(batch);
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return static_cast<double>(order.size()) / elapsed.count();
+}
+} // namespace
+
+int main() {
+  std::remove(file);
+  int fd = open(file, O_RDWR | O_CREAT, 0644);
+  if (fd == -1) {
+    std::perror("open");
+    return 1;
+  }
+  db::Page page{};
+  for (size_t i = 0; i < FILE_PAGES; i++) {
+    page[0] = static_cast<uint8_t>(i);
+    if (pwrite(fd, page.data(), page.size(), static_cast<off_t>(i * db::DEFAULT_PAGE_SIZE)) == -1) {
+      std::perror("pwrite");
+      return 1;
+    }
+  }
+  fsync(fd);
+
+  std::vector<size_t> sequential(READS);
+  std::iota(sequential.begin(), sequential.end(), 0);
+  for (size_t &id : sequential) {
+    id %= FILE_PAGES;
+  }
+  std::vector<size_t> random(READS);
+  std::mt19937_64 rng(42);
+  std::generate(random.begin(), random.end(), [&] { return rng() % FILE_PAGES; });
+
+  std::printf("%10s %8s %16s %16s\n", "engine", "depth", "seq pages/s", "random pages/s");
+  for (db::IoEngineType type : {db::IoEngineType::POSIX, db::IoEngineType::IO_URING}) {
+    for (size_t depth = 1; depth <= 64; depth *= 2) {
+      auto engine = db::IoEngine::create(type, depth);
+      // The engine reports POSIX if io_uring is not available
+      const char *name = engine->type() == db::IoEngineType::POSIX ? "posix" : "io_uring";
+      double seq = run(*engine, fd, sequential, depth);
+      double rand = run(*engine, fd, random, depth);
+      std::printf("%10s %8zu %16.0f %16.0f\n", name, depth, seq, rand);
+    }
+  }
+
+  close(fd);
+  std::remove(file);
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/HeapPage.hpp>
+
+/**
+ * Heap file scans through the buffer pool (pread into frames) and through a read-only mapping of the file.
+ * Startup is the time from opening the file to the first tuple of a scan. Throughput is measured over full scans that
+ * advance the iterator without deserializing the tuples, so it is dominated by getting the pages. The file is in the
+ * page cache of the OS for every run, so the difference is the copy into the frames.
+ */
+
+namespace {
+constexpr size_t FILE_PAGES = 8192;
+constexpr size_t SCANS = 3;
+
+const std::string file = "mmap_bench.dat";
+
+db::TupleDesc schema() { return {{db::type_t::INT, db::type_t::DOUBLE}, {"id", "value"}}; }
+
+void run(const char *label, bool mapped) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+
+  auto begin = std::chrono::steady_clock::now();
+  db.add(std::make_unique<db::HeapFile>(file, schema()));
+  db::DbFile &heap = db.get(file);
+  if (mapped) {
+    heap.map(db::AccessPattern::SEQUENTIAL);
+  }
+  (*heap.begin()).get_field(0);
+  std::chrono::duration<double, std::micro> startup = std::chrono::steady_clock::now() - begin;
+
+  size_t tuples = 0;
+  begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    for (auto it = heap.begin(); it != heap.end(); ++it) {
+      tuples++;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  std::printf("%8s %8s %12.1f %14.0f %14.0f %12zu\n", label, heap.isMapped() ? "yes" : "no", startup.count(),
+              tuples / elapsed.count(), SCANS * FILE_PAGES / elapsed.count(), heap.getIoStats().pages_read);
+  db.remove(file);
+}
+} // namespace
+
+int main() {
+  std::remove(file.c_str());
+  {
+    db::DbFile out(file, schema());
+    db::TupleDesc td = schema();
+    db::Page page{};
+    int id = 0;
+    for (size_t i = 0; i < FILE_PAGES; i++) {
+      page.fill(0);
+      db::HeapPage hp(page, td);
+      while (hp.insertTuple({{id, 0.5}})) {
+        id++;
+      }
+      out.writePage(page, i);
+    }
+  }
+
+  std::printf("%8s %8s %12s %14s %14s %12s\n", "path", "mmap", "startup us", "tuples/s", "pages/s", "preads");
+  // Warm the page cache so that both paths read the same, cached file
+  run("pread", false);
+  run("pread", false);
+  run("mmap", true);
+
+  std::remove(file.c_str());
+  return 0;
+}
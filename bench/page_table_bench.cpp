@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdio>
+#include <db/BufferPool.hpp>
+#include <db/PageTable.hpp>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Lookup cost of the open-addressing page table against the node-based std::unordered_map it replaced, for a full
+ * table of `size` pages of a few files. Every lookup hits, like a buffer pool hit. With several shards, the table is
+ * the one of a single shard of a pool of `size` frames, and holds only the pages that map to that shard.
+ */
+
+namespace {
+constexpr size_t LOOKUPS = 1 << 23;
+
+template <typename Lookup> double measure(const std::vector<db::PageId> &keys, Lookup lookup) {
+  uint64_t x = 0x9e3779b97f4a7c15ULL;
+  size_t sum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < LOOKUPS; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sum += lookup(keys[x % keys.size()]);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  // Keep the lookups from being optimized away
+  if (sum == 0) {
+    std::printf("-");
+  }
+  return elapsed.count() / LOOKUPS;
+}
+} // namespace
+
+int main() {
+  std::printf("%10s %8s %16s %16s\n", "pages", "shards", "unordered_map ns", "PageTable ns");
+  for (size_t size : {1024, 16384, 262144, 1048576}) {
+    for (size_t shards : {1, 16, 64}) {
+      size_t entries = size / shards;
+      std::vector<db::PageId> keys;
+      std::mt19937_64 rng(42);
+      db::PageTable table(entries);
+      std::unordered_map<const db::PageId, size_t> map;
+      map.reserve(entries);
+      for (size_t i = 0; i < entries * shards; i++) {
+        db::PageId pid{static_cast<db::file_id_t>(rng() % 4), rng() % (4 * size)};
+        if (db::BufferPool::shardIndex(pid, shards) != 0 || map.contains(pid) || keys.size() == entries) {
+          continue;
+        }
+        keys.push_back(pid);
+        map[pid] = i;
+        table.insert(pid, i);
+      }
+      double node = measure(keys, [&](const db::PageId &pid) { return map.find(pid)->second; });
+      double flat = measure(keys, [&](const db::PageId &pid) { return table.find(pid); });
+      std::printf("%10zu %8zu %16.1f %16.1f\n", size, shards, node, flat);
+    }
+  }
+  return 0;
+}
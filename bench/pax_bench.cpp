@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <db/Query.hpp>
+
+/**
+ * Column-at-a-time queries over a resident heap file of wide rows (INT, CHAR, CHAR, DOUBLE), once with the row layout
+ * and once with the PAX layout. Sum reads the INT column of every batch directly, aggregate and filter run the query
+ * operators, the filter with a predicate on the DOUBLE column that selects 1% of the rows.
+ */
+
+namespace {
+constexpr size_t ROWS = 500'000;
+constexpr size_t SCANS = 10;
+
+const std::string file = "pax_bench.dat";
+const std::string out = "pax_bench.out";
+
+db::TupleDesc schema() {
+  return {{db::type_t::INT, db::type_t::CHAR, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "note", "value"}};
+}
+
+template <typename F> double rate(F &&query) {
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    query();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return ROWS * SCANS / elapsed.count();
+}
+
+void run(const char *label, db::PageLayout layout) {
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = 16384, .scan_ring_pages = 0});
+  db.add(std::make_unique<db::HeapFile>(file, schema(), layout));
+  auto &heap = dynamic_cast<db::HeapFile &>(db.get(file));
+  {
+    db::HeapLoader loader(heap);
+    for (size_t i = 0; i < ROWS; i++) {
+      loader.append({{static_cast<int>(i), "name", "note", static_cast<double>(i % 100)}});
+    }
+  }
+
+  long sum = 0;
+  double sum_rate = rate([&] {
+    db::PageBatch batch;
+    for (auto it = heap.begin(); heap.nextBatch(it, batch);) {
+      const uint8_t *column = batch.column(0);
+      size_t stride = batch.columnStride(0);
+      for (size_t slot : batch.slots) {
+        int id;
+        std::memcpy(&id, column + slot * stride, sizeof(id));
+        sum += id;
+      }
+    }
+  });
+
+  auto aggregate_rate = rate([&] {
+    std::remove(out.c_str());
+    db.add(std::make_unique<db::HeapFile>(out, db::TupleDesc({db::type_t::INT}, {"sum"})));
+    db::aggregate(heap, db.get(out), {std::nullopt, db::AggregateOp::SUM, "id"});
+    db.remove(out);
+  });
+
+  auto filter_rate = rate([&] {
+    std::remove(out.c_str());
+    db.add(std::make_unique<db::HeapFile>(out, schema()));
+    db::filter(heap, db.get(out), {{"value", db::PredicateOp::EQ, 0.0}});
+    db.remove(out);
+  });
+
+  std::printf("%-6s %14.0f %14.0f %14.0f %16ld\n", label, sum_rate, aggregate_rate, filter_rate, sum);
+  db.remove(file);
+}
+} // namespace
+
+int main() {
+  std::printf("%-6s %14s %14s %14s %16s\n", "layout", "sum rows/s", "agg rows/s", "filter rows/s", "sum");
+  run("row", db::PageLayout::ROW);
+  run("pax", db::PageLayout::PAX);
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  std::remove(out.c_str());
+  std::remove((out + ".fsm").c_str());
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <random>
+#include <vector>
+
+/**
+ * Replacement policies compared on the cost of a buffer pool hit and on the hit ratio of a skewed workload and of a
+ * hot working set interleaved with large sequential scans.
+ */
+
+namespace {
+constexpr size_t NUM_PAGES = 1024;
+constexpr size_t HIT_LOOKUPS = 1 << 22;
+constexpr size_t ACCESSES = 1 << 20;
+
+struct Policy {
+  const char *name;
+  db::ReplacementPolicyType type;
+};
+
+const std::string file = "replacement_bench.dat";
+
+void configure(db::ReplacementPolicyType type) {
+  db::getDatabase().configureBufferPool({.num_pages = NUM_PAGES, .policy = type});
+}
+
+double hitCost(db::ReplacementPolicyType type) {
+  configure(type);
+  db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+  constexpr size_t working_set = NUM_PAGES / 2;
+  for (size_t page = 0; page < working_set; page++) {
+    bufferPool.getPage({file, page});
+  }
+  std::mt19937_64 rng(42);
+  std::vector<size_t> pages(HIT_LOOKUPS);
+  std::generate(pages.begin(), pages.end(), [&] { return rng() % working_set; });
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t page : pages) {
+    bufferPool.getPage({file, page});
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  return elapsed.count() / HIT_LOOKUPS;
+}
+
+/// Zipf(1) over 16x more pages than the pool holds
+double skewedHitRatio(db::ReplacementPolicyType type) {
+  configure(type);
+  db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+  constexpr size_t pages = 16 * NUM_PAGES;
+  std::vector<double> cdf(pages);
+  double sum = 0;
+  for (size_t i = 0; i < pages; i++) {
+    sum += 1.0 / static_cast<double>(i + 1);
+    cdf[i] = sum;
+  }
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> uniform(0, sum);
+  size_t hits = 0;
+  for (size_t i = 0; i < ACCESSES; i++) {
+    size_t page = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+    hits += bufferPool.contains({file, page});
+    bufferPool.getPage({file, page});
+  }
+  return static_cast<double>(hits) / ACCESSES;
+}
+
+/// Uniform accesses to a hot set of half the pool, with a scan of 4x the pool after every 8192 accesses
+double scanHitRatio(db::ReplacementPolicyType type) {
+  configure(type);
+  db::BufferPool &bufferPool = db::getDatabase().getBufferPool();
+  constexpr size_t hot = NUM_PAGES / 2;
+  constexpr size_t scan = 4 * NUM_PAGES;
+  std::mt19937_64 rng(42);
+  size_t hits = 0;
+  for (size_t i = 0; i < ACCESSES; i++) {
+    if (i % 8192 == 0) {
+      for (size_t page = 0; page < scan; page++) {
+        bufferPool.getPage({file, hot + page});
+      }
+    }
+    size_t page = rng() % hot;
+    hits += bufferPool.contains({file, page});
+    bufferPool.getPage({file, page});
+  }
+  return static_cast<double>(hits) / ACCESSES;
+}
+} // namespace
+
+int main() {
+  std::remove(file.c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::DbFile>(file, db::TupleDesc()));
+
+  const Policy policies[] = {
+      {"LRU", db::ReplacementPolicyType::LRU},
+      {"CLOCK", db::ReplacementPolicyType::CLOCK},
+      {"2Q", db::ReplacementPolicyType::TWO_Q},
+  };
+  std::printf("%8s %12s %16s %16s\n", "policy", "ns/hit", "skewed hit%", "scan+hot hit%");
+  for (const Policy &policy : policies) {
+    double cost = hitCost(policy.type);
+    double skewed = skewedHitRatio(policy.type);
+    double scan = scanHitRatio(policy.type);
+    std::printf("%8s %12.1f %16.2f %16.2f\n", policy.name, cost, 100 * skewed, 100 * scan);
+  }
+
+  db.remove(file);
+  std::remove(file.c_str());
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+#include <new>
+
+/**
+ * Scans of a heap file of (INT, CHAR, DOUBLE) rows that sum the INT column and count the rows whose CHAR column
+ * matches, once deserializing every row with `*it` and once reading the fields through `it.view()`. Allocations are
+ * counted by replacing the global operator new, and reported per scanned row. The file is resident in the pool.
+ */
+
+namespace {
+std::atomic<size_t> allocations = 0;
+
+constexpr size_t ROWS = 500'000;
+constexpr size_t SCANS = 5;
+
+const std::string file = "tuple_view_bench.dat";
+
+db::TupleDesc schema() { return {{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE}, {"id", "name", "value"}}; }
+
+void run(const char *label, db::DbFile &heap, bool view) {
+  long sum = 0;
+  size_t matches = 0;
+  size_t rows = 0;
+  size_t before = allocations.load();
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    for (auto it = heap.begin(); it != heap.end(); ++it) {
+      if (view) {
+        db::TupleView t = it.view();
+        sum += t.get_int(0);
+        matches += t.get_char(1) == "even";
+      } else {
+        db::Tuple t = *it;
+        sum += std::get<int>(t.get_field(0));
+        matches += std::get<db::string_t>(t.get_field(1)) == "even";
+      }
+      rows++;
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  double per_row = static_cast<double>(allocations.load() - before) / static_cast<double>(rows);
+  std::printf("%-8s %14.0f %16.3f %14ld %10zu\n", label, rows / elapsed.count(), per_row, sum, matches);
+}
+} // namespace
+
+void *operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+int main() {
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = 16384, .scan_ring_pages = 0});
+  db.add(std::make_unique<db::HeapFile>(file, schema()));
+  auto &heap = dynamic_cast<db::HeapFile &>(db.get(file));
+  {
+    db::HeapLoader loader(heap);
+    for (size_t i = 0; i < ROWS; i++) {
+      // Longer than the small string buffer, so that copies of it allocate
+      std::string name = i % 2 == 0 ? "even" : "odd row with a long name";
+      loader.append({{static_cast<int>(i), name, 0.5}});
+    }
+  }
+
+  std::printf("%-8s %14s %16s %14s %10s\n", "access", "rows/s", "allocs/row", "sum", "matches");
+  run("tuple", heap, false);
+  run("tuple", heap, false);
+  run("view", heap, true);
+
+  db.remove(file);
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  return 0;
+}
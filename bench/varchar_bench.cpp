@@ -0,0 +1,60 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/HeapFile.hpp>
+
+/**
+ * Scans of a heap file of (INT, code, name) rows whose strings are short (a 3-character code and a name of 8 to 24
+ * characters), once with CHAR columns in fixed-length pages and once with VARCHAR columns in slotted pages. The pool
+ * holds a small part of the file, so every scan reads the file, and reports the pages read per scan with the rate.
+ */
+
+namespace {
+constexpr size_t ROWS = 300'000;
+constexpr size_t SCANS = 5;
+
+const std::string file = "varchar_bench.dat";
+
+void run(const char *label, db::type_t type) {
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = 256});
+  db.add(std::make_unique<db::HeapFile>(file, db::TupleDesc({db::type_t::INT, type, type}, {"id", "code", "name"})));
+  auto &heap = dynamic_cast<db::HeapFile &>(db.get(file));
+  {
+    db::HeapLoader loader(heap);
+    for (size_t i = 0; i < ROWS; i++) {
+      loader.append({{static_cast<int>(i), "ABC", "customer " + std::string(i % 16, 'x')}});
+    }
+  }
+
+  size_t before = heap.getIoStats().pages_read;
+  size_t rows = 0;
+  size_t chars = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < SCANS; i++) {
+    db::PageBatch batch;
+    for (auto it = heap.begin(); heap.nextBatch(it, batch);) {
+      for (size_t row = 0; row < batch.size(); row++) {
+        chars += batch.view(row).get_char(2).size();
+      }
+      rows += batch.size();
+    }
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  size_t pages_read = (heap.getIoStats().pages_read - before) / SCANS;
+  std::printf("%-8s %8zu %12zu %14.0f %10zu\n", label, heap.getNumPages(), pages_read, rows / elapsed.count(),
+              chars / SCANS);
+  db.remove(file);
+}
+} // namespace
+
+int main() {
+  std::printf("%-8s %8s %12s %14s %10s\n", "type", "pages", "pages/scan", "rows/s", "chars");
+  run("CHAR", db::type_t::CHAR);
+  run("VARCHAR", db::type_t::VARCHAR);
+  std::remove(file.c_str());
+  std::remove((file + ".fsm").c_str());
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <random>
+
+/**
+ * Foreground cost of an update-heavy workload with and without the background writer.
+ * Every access dirties a random page of a file 4x larger than the pool, so most misses evict a dirty page.
+ */
+
+namespace {
+constexpr size_t NUM_PAGES = 1024;
+constexpr size_t FILE_PAGES = 4 * NUM_PAGES;
+constexpr size_t ACCESSES = 1 << 18;
+
+const std::string file = "writer_bench.dat";
+
+void run(const char *label, double clean_fraction) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = NUM_PAGES,
+                          .writer_clean_fraction = clean_fraction,
+                          .writer_interval = std::chrono::milliseconds(1),
+                          .writer_max_pages = 256});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  size_t writes = db.get(file).getWrites().size();
+  std::mt19937_64 rng(42);
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < ACCESSES; i++) {
+    db::PageId pid{file, rng() % FILE_PAGES};
+    bufferPool.getPage(pid)[0]++;
+    bufferPool.markDirty(pid);
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - begin;
+  db::WriterStats stats = bufferPool.getWriterStats();
+  size_t foreground = db.get(file).getWrites().size() - writes - stats.pages;
+  std::printf("%12s %12.1f %16zu %16zu %12zu %16.0f\n", label, elapsed.count() / ACCESSES, foreground, stats.pages,
+              stats.writes, stats.pages_per_second);
+}
+} // namespace
+
+int main() {
+  std::remove(file.c_str());
+  db::Database &db = db::getDatabase();
+  db.add(std::make_unique<db::DbFile>(file, db::TupleDesc()));
+
+  std::printf("%12s %12s %16s %16s %12s %16s\n", "writer", "ns/access", "foreground pgs", "background pgs",
+              "batches", "pages/s");
+  run("off", 0);
+  run("10% clean", 0.1);
+  run("25% clean", 0.25);
+
+  db.remove(file);
+  std::remove(file.c_str());
+  return 0;
+}
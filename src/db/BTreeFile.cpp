@@ -7,24 +7,44 @@
 
 using namespace db;
 
+namespace {
+/// Reports the leaf a scan moved to, the leaves that follow it are read ahead along their next_leaf pointers
+void readAhead(const Iterator &it, const LeafPage &leaf, size_t root_id) {
+  auto successor = [root_id](const Page &page) {
+    size_t next = reinterpret_cast<const LeafPageHeader *>(page.data())->next_leaf;
+    return next == root_id ? PrefetchRequest::npos : next;
+  };
+  size_t next = leaf.header->next_leaf == root_id ? PrefetchRequest::npos : leaf.header->next_leaf;
+  it.read_ahead->advance(it.page, next, successor);
+}
+} // namespace
+
 BTreeFile::BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index)
-    : DbFile(name, td), key_index(key_index) {}
+    : DbFile(name, td), key_index(key_index) {
+  // Leaves store the tuples at fixed positions, sorted by key
+  if (!td.is_fixed()) {
+    throw std::logic_error("B+ tree tuples must have a fixed length");
+  }
+  if (td.is_nullable(key_index)) {
+    throw std::logic_error("B+ tree key must not be nullable");
+  }
+}
 
 void BTreeFile::insertTuple(const Tuple &t) {
   std::vector<size_t> path;
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, root_id};
+  PageId pid{id, root_id};
 
-  Page &root_page = bufferPool.getPage(pid);
-  IndexPage root(root_page);
+  PageGuard root_page = bufferPool.fetchPage(pid);
+  IndexPage root(*root_page);
   if (root.header->size == 0 && root.children[0] != 1) {
-    bufferPool.markDirty({name, root_id});
+    root_page.markDirty();
     pid.page = numPages++;
     root.children[0] = pid.page;
   } else {
     while (true) {
-      Page &page = bufferPool.getPage(pid);
-      IndexPage node(page);
+      PageGuard page = bufferPool.fetchPage(pid);
+      IndexPage node(*page);
       auto pos = std::lower_bound(node.keys, node.keys + node.header->size, std::get<int>(t.get_field(key_index)));
       auto slot = pos - node.keys;
       pid.page = node.children[slot];
@@ -35,17 +55,15 @@ void BTreeFile::insertTuple(const Tuple &t) {
     }
   }
 
-  Page &page = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
-  LeafPage leaf(page, td, key_index);
+  PageGuard page = bufferPool.fetchPage(pid, true);
+  LeafPage leaf(*page, td, key_index);
   if (!leaf.insertTuple(t)) {
     return;
   }
 
   pid.page = numPages++;
-  Page &new_leaf_page = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
-  LeafPage new_leaf(new_leaf_page, td, key_index);
+  PageGuard new_leaf_page = bufferPool.fetchPage(pid, true);
+  LeafPage new_leaf(*new_leaf_page, td, key_index);
   int new_key = leaf.split(new_leaf);
   leaf.header->next_leaf = pid.page;
   size_t new_child = pid.page;
@@ -54,37 +72,33 @@ void BTreeFile::insertTuple(const Tuple &t) {
     size_t parent_id = path.back();
     path.pop_back();
     pid.page = parent_id;
-    Page &parent_page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    IndexPage parent(parent_page);
+    PageGuard parent_page = bufferPool.fetchPage(pid, true);
+    IndexPage parent(*parent_page);
     if (!parent.insert(new_key, new_child)) {
       return;
     }
 
     pid.page = numPages++;
-    Page &new_internal_page = bufferPool.getPage(pid);
-    bufferPool.markDirty(pid);
-    IndexPage new_internal(new_internal_page);
+    PageGuard new_internal_page = bufferPool.fetchPage(pid, true);
+    IndexPage new_internal(*new_internal_page);
     new_key = parent.split(new_internal);
     new_child = pid.page;
   }
 
-  bufferPool.markDirty({name, root_id});
+  root_page.markDirty();
   if (!root.insert(new_key, new_child)) {
     return;
   }
   pid.page = numPages++;
-  Page &new_child1 = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
+  PageGuard new_child1 = bufferPool.fetchPage(pid, true);
   size_t child1 = pid.page;
-  new_child1 = root_page;
-  IndexPage child1_page(new_child1);
+  *new_child1 = *root_page;
+  IndexPage child1_page(*new_child1);
 
   pid.page = numPages++;
-  Page &new_child2 = bufferPool.getPage(pid);
-  bufferPool.markDirty(pid);
+  PageGuard new_child2 = bufferPool.fetchPage(pid, true);
   size_t child2 = pid.page;
-  IndexPage child2_page(new_child2);
+  IndexPage child2_page(*new_child2);
 
   int key = child1_page.split(child2_page);
   root.header->size = 1;
@@ -98,38 +112,98 @@ void BTreeFile::deleteTuple(const Iterator &it) {
 }
 
 Tuple BTreeFile::getTuple(const Iterator &it) const {
-  BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &page = bufferPool.getPage(pid);
-  LeafPage leaf(page, td, key_index);
-  return leaf.getTuple(it.slot);
+  PageGuard page = it.guard && it.guard.getPageId().page == it.page ? it.guard : fetchForRead(it.page);
+  LeafPage leaf(*page, td, key_index);
+  return it.projection.empty() ? leaf.getTuple(it.slot) : leaf.getView(it.slot).materialize(it.projection);
+}
+
+TupleView BTreeFile::getTupleView(Iterator &it) const {
+  if (!it.guard || it.guard.getPageId().page != it.page) {
+    it.guard = fetchForRead(it.page, it.ring.get());
+  }
+  const LeafPage leaf(*it.guard, td, key_index);
+  return leaf.getView(it.slot);
 }
 
 void BTreeFile::next(Iterator &it) const {
-  BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &page = bufferPool.getPage(pid);
-  LeafPage leaf(page, td, key_index);
+  if (!it.guard || it.guard.getPageId().page != it.page) {
+    it.guard = fetchForRead(it.page, it.ring.get());
+  }
+  LeafPage leaf(*it.guard, td, key_index);
   if (it.slot + 1 < leaf.header->size) {
     it.slot++;
   } else {
     it.page = leaf.header->next_leaf;
     it.slot = 0;
+    it.guard.release();
+    if (it.page != root_id) {
+      it.guard = fetchForRead(it.page, it.ring.get());
+      if (it.read_ahead) {
+        readAhead(it, LeafPage(*it.guard, td, key_index), root_id);
+      }
+    }
+  }
+}
+
+bool BTreeFile::nextBatch(Iterator &it, PageBatch &batch, size_t max_rows) const {
+  batch.clear();
+  while (it.page != root_id) {
+    if (!it.guard || it.guard.getPageId().page != it.page) {
+      it.guard = fetchForRead(it.page, it.ring.get());
+      if (it.read_ahead) {
+        readAhead(it, LeafPage(*it.guard, td, key_index), root_id);
+      }
+    }
+    const LeafPage leaf(*it.guard, td, key_index);
+    size_t slot = it.slot;
+    for (; slot < leaf.header->size && batch.slots.size() < max_rows; slot++) {
+      batch.slots.push_back(slot);
+    }
+    if (!batch.slots.empty()) {
+      batch.page = it.guard;
+      batch.td = &td;
+      batch.data = leaf.data;
+      batch.stride = td.length();
+    }
+    if (slot < leaf.header->size) {
+      it.slot = slot;
+      return true;
+    }
+    // The next leaf is pinned by the next batch
+    it.page = leaf.header->next_leaf;
+    it.slot = 0;
+    it.guard.release();
+    if (!batch.slots.empty()) {
+      return true;
+    }
   }
+  return false;
 }
 
 Iterator BTreeFile::begin() const {
   BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, root_id};
+  PageId pid{id, root_id};
   while (true) {
-    Page &page = bufferPool.getPage(pid);
-    IndexPage node(page);
+    PageGuard page = fetchForRead(pid.page);
+    IndexPage node(*page);
     pid.page = node.children[0];
     if (!node.header->index_children) {
       break;
     }
   }
-  return {*this, pid.page, 0};
+  if (pid.page == root_id) {
+    return end();
+  }
+  // The leaves are scanned through a ring, the index pages on the way down stay regular pages
+  std::shared_ptr<ScanRing> ring = bufferPool.makeScanRing();
+  PageGuard leaf = fetchForRead(pid.page, ring.get());
+  // Pages of a mapped file are read ahead by the kernel
+  std::shared_ptr<ReadAhead> read_ahead = isMapped() ? nullptr : bufferPool.makeReadAhead(*this);
+  Iterator it{*this, pid.page, 0, std::move(leaf), std::move(ring), std::move(read_ahead)};
+  if (it.read_ahead) {
+    readAhead(it, LeafPage(*it.guard, td, key_index), root_id);
+  }
+  return it;
 }
 
 Iterator BTreeFile::end() const {
@@ -1,93 +1,793 @@
 #include <db/BufferPool.hpp>
+#include <algorithm>
+#include <cmath>
 #include <db/Database.hpp>
 #include <numeric>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <tuple>
+#include <utility>
 
 using namespace db;
 
-BufferPool::BufferPool() : available(DEFAULT_NUM_PAGES) { std::iota(available.rbegin(), available.rend(), 0); }
+namespace {
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
 
-BufferPool::~BufferPool() {
-  for (const size_t &pos : dirty) {
-    const Page &page = pages[pos];
-    const PageId &pid = pos_to_pid[pos];
-    getDatabase().get(pid.file).writePage(page, pid.page);
+/**
+ * @brief Map an anonymous, zero-filled region for the frames.
+ * @details mmap returns memory aligned to the OS page size, so every frame is page-aligned. With huge pages, the region
+ * is rounded up to the huge page size and explicit huge pages are tried first; when none are reserved the region falls
+ * back to regular pages with a transparent huge page hint.
+ */
+Page *mapFrames(size_t &bytes, bool huge_pages) {
+  void *mem = MAP_FAILED;
+  if (huge_pages) {
+    bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  }
+  if (mem == MAP_FAILED) {
+    mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) {
+      madvise(mem, bytes, MADV_HUGEPAGE);
+    }
+#endif
   }
+  return static_cast<Page *>(mem);
 }
+} // namespace
 
-Page &BufferPool::getPage(const PageId &pid) {
-  // If already in buffer pool, make it the most recent page and return it
-  if (contains(pid)) {
-    size_t pos = pid_to_pos.at(pid);
-    lru_list.splice(lru_list.begin(), lru_list, pos_to_lru[pos]);
-    pos_to_lru[pos] = lru_list.begin();
-    return pages[pos];
+double BufferPoolCounters::hitRatio() const {
+  size_t fetches = hits + misses;
+  return fetches == 0 ? 0 : static_cast<double>(hits) / static_cast<double>(fetches);
+}
+
+BufferPoolCounters &BufferPoolCounters::operator+=(const BufferPoolCounters &other) {
+  hits += other.hits;
+  misses += other.misses;
+  evictions += other.evictions;
+  dirty_evictions += other.dirty_evictions;
+  flushes += other.flushes;
+  miss_latency += other.miss_latency;
+  return *this;
+}
+
+BufferPoolConfig BufferPoolConfig::fromBytes(size_t bytes) {
+  if (bytes < DEFAULT_PAGE_SIZE) {
+    throw std::invalid_argument("Buffer pool budget is smaller than a page");
   }
+  return {bytes / DEFAULT_PAGE_SIZE};
+}
 
-  // If there are no available pages, evict the least recently used page. If the page is dirty, flush it to disk
-  if (available.empty()) {
-    size_t pos = lru_list.back();
-    const PageId &old_pid = pos_to_pid.at(pos);
-    if (isDirty(old_pid)) {
-      flushPage(old_pid);
+BufferPool::Shard::Shard(size_t index, Page *pages, size_t num_pages, const BufferPoolConfig &config)
+    : index(index), pages(pages), num_frames(num_pages), frames(std::make_unique<Frame[]>(num_pages)),
+      pid_to_pos(num_pages), available(num_pages), policy(ReplacementPolicy::create(config.policy, num_pages)),
+      eviction_write_batch(std::max<size_t>(1, config.eviction_write_batch)) {
+  std::iota(available.rbegin(), available.rend(), 0);
+}
+
+BufferPoolCounters &BufferPool::Shard::statsOf(file_id_t file) {
+  if (file >= stats.size()) {
+    stats.resize(file + 1);
+  }
+  return stats[file];
+}
+
+size_t BufferPool::Shard::fetch(std::unique_lock<std::mutex> &lock, const PageId &pid, ScanRing *ring) {
+  size_t pos = pid_to_pos.find(pid);
+  // Only misses are timed, so hits do not read the clock
+  auto start = pos == PageTable::npos ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+  bool waited = false;
+  while (pos == PageTable::npos) {
+    if (loading.contains(pid)) {
+      // The prefetcher is reading the page: wait for it instead of reading it again
+      prefetch_stats.misses++;
+      io_done.wait(lock, [&] { return !loading.contains(pid); });
+      waited = true;
+    } else if (writing.contains(pid)) {
+      // The page was evicted while the background writer writes it back: the read must see the written contents
+      io_done.wait(lock, [&] { return !writing.contains(pid); });
+    } else {
+      break;
+    }
+    pos = pid_to_pos.find(pid);
+  }
+  if (pos != PageTable::npos) {
+    BufferPoolCounters &counters = statsOf(pid.file);
+    if (start == std::chrono::steady_clock::time_point()) {
+      counters.hits++;
+    } else {
+      counters.misses++;
+      counters.miss_latency.record(std::chrono::steady_clock::now() - start);
+    }
+    bool was_prefetched = frames[pos].prefetched;
+    if (was_prefetched) {
+      frames[pos].prefetched = false;
+      prefetch_stats.hits += !waited;
     }
-    discardPage(old_pid);
+    if (ring) {
+      // Scans do not count as accesses, so they neither promote hot pages nor keep their own pages alive.
+      // Pages that were loaded ahead of the scan join its ring, like the pages the scan reads itself.
+      if (was_prefetched && !frames[pos].ring_owner) {
+        adopt(pos, *ring);
+      }
+      return pos;
+    }
+    if (frames[pos].ring_owner) {
+      // A page of a scan is also used outside of it: the frame leaves the ring and becomes a regular frame
+      frames[pos].ring_owner = nullptr;
+      policy->insert(pos, std::hash<const PageId>()(pid));
+    } else {
+      policy->touch(pos);
+    }
+    return pos;
   }
 
-  // Read the page from disk to one of the available slots, make it the most recent page
-  size_t pos = available.back();
-  available.pop_back();
+  if (prefetcher && prefetcher->take(pid)) {
+    prefetch_stats.misses++;
+  }
+  pos = ring ? reuseRingFrame(*ring) : ReplacementPolicy::npos;
+  if (pos == ReplacementPolicy::npos) {
+    pos = allocate();
+  }
 
-  Page &page = pages[pos];
-  getDatabase().get(pid.file).readPage(page, pid.page);
-  pid_to_pos[pid] = pos;
-  pos_to_pid[pos] = pid;
+  // Read the page from disk to the frame and start tracking it. The frame was already evicted, so it is free again if
+  // the read fails.
+  try {
+    getDatabase().get(pid.file).readPage(pages[pos], pid.page);
+  } catch (...) {
+    frames[pos].ring_owner = nullptr;
+    available.push_back(pos);
+    throw;
+  }
+  pid_to_pos.insert(pid, pos);
+  frames[pos].pid = pid;
+  BufferPoolCounters &counters = statsOf(pid.file);
+  counters.misses++;
+  counters.miss_latency.record(std::chrono::steady_clock::now() - start);
 
-  lru_list.push_front(pos);
-  pos_to_lru[pos] = lru_list.begin();
+  if (ring) {
+    frames[pos].ring_owner = ring;
+    std::vector<size_t> &ring_frames = ring->frames[index];
+    if (std::find(ring_frames.begin(), ring_frames.end(), pos) == ring_frames.end()) {
+      ring_frames.push_back(pos);
+    }
+  } else {
+    policy->insert(pos, std::hash<const PageId>()(pid));
+  }
+  return pos;
+}
 
-  return page;
+size_t BufferPool::Shard::allocate() {
+  // If there are no available pages, evict an unpinned page chosen by the policy
+  if (available.empty()) {
+    size_t victim = policy->victim([this](size_t pos) { return evictable(pos); });
+    if (victim == ReplacementPolicy::npos) {
+      throw std::runtime_error("All buffer pool frames are pinned");
+    }
+    evict(victim);
+    return victim;
+  }
+  size_t pos = available.back();
+  available.pop_back();
+  return pos;
 }
 
-void BufferPool::markDirty(const PageId &pid) {
-  size_t pos = pid_to_pos.at(pid);
-  dirty.insert(pos);
+size_t BufferPool::Shard::reuseRingFrame(ScanRing &ring) {
+  std::vector<size_t> &ring_frames = ring.frames[index];
+  std::erase_if(ring_frames, [&](size_t pos) { return frames[pos].ring_owner != &ring; });
+  if (ring_frames.size() < ring.frames_per_shard) {
+    return ReplacementPolicy::npos;
+  }
+  // Recycle the oldest unpinned frame of the ring; if they are all pinned the ring grows by a regular frame
+  size_t &cursor = ring.cursor[index];
+  for (size_t i = 0; i < ring_frames.size(); i++) {
+    size_t pos = ring_frames[(cursor + i) % ring_frames.size()];
+    if (evictable(pos)) {
+      cursor = (cursor + i + 1) % ring_frames.size();
+      evict(pos);
+      return pos;
+    }
+  }
+  return ReplacementPolicy::npos;
 }
 
-bool BufferPool::isDirty(const PageId &pid) const {
-  size_t pos = pid_to_pos.at(pid);
-  return dirty.contains(pos);
+void BufferPool::Shard::adopt(size_t pos, ScanRing &ring) {
+  // A full ring frees its oldest unpinned frame to make room
+  size_t old = reuseRingFrame(ring);
+  if (old != ReplacementPolicy::npos) {
+    frames[old].ring_owner = nullptr;
+    available.push_back(old);
+  }
+  policy->erase(pos);
+  frames[pos].ring_owner = &ring;
+  ring.frames[index].push_back(pos);
 }
 
-bool BufferPool::contains(const PageId &pid) const { return pid_to_pos.contains(pid); }
+bool BufferPool::Shard::evictable(size_t pos) const {
+  if (frames[pos].pins.load(std::memory_order_acquire) != 0) {
+    return false;
+  }
+  // Writing the page again while an older copy is being written back could leave the older copy on disk
+  return !frames[pos].dirty || writing.empty() || !writing.contains(frames[pos].pid);
+}
 
-void BufferPool::discardPage(const PageId &pid) {
+void BufferPool::Shard::evict(size_t pos) {
+  // If the page is dirty, flush it to disk, along with other dirty pages that are about to be evicted
+  const PageId pid = frames[pos].pid;
+  BufferPoolCounters &counters = statsOf(pid.file);
+  counters.evictions++;
+  counters.dirty_evictions += frames[pos].dirty;
+  if (frames[pos].dirty && eviction_write_batch > 1) {
+    std::vector<size_t> batch{pos};
+    std::vector<size_t> cold;
+    policy->coldest(4 * eviction_write_batch, cold);
+    for (size_t other : cold) {
+      if (batch.size() == eviction_write_batch) {
+        break;
+      }
+      if (other != pos && frames[other].dirty && evictable(other)) {
+        batch.push_back(other);
+      }
+    }
+    writeFrames(batch);
+  } else {
+    flushPage(pid);
+  }
+  pid_to_pos.erase(pid);
+  frames[pos].pid = {};
+  if (!frames[pos].ring_owner) {
+    policy->erase(pos);
+  }
+  if (frames[pos].prefetched) {
+    frames[pos].prefetched = false;
+    prefetch_stats.wasted++;
+  }
+}
+
+void BufferPool::Shard::discardPage(const PageId &pid) {
   size_t pos = pid_to_pos.at(pid);
+  if (frames[pos].pins.load(std::memory_order_acquire) != 0) {
+    throw std::logic_error("Cannot discard a pinned page");
+  }
   pid_to_pos.erase(pid);
-  pos_to_pid[pos] = {};
+  frames[pos].pid = {};
 
-  lru_list.erase(pos_to_lru[pos]);
-  pos_to_lru.erase(pos);
-  dirty.erase(pos);
+  if (frames[pos].ring_owner) {
+    frames[pos].ring_owner = nullptr;
+  } else {
+    policy->erase(pos);
+  }
+  if (frames[pos].prefetched) {
+    frames[pos].prefetched = false;
+    prefetch_stats.wasted++;
+  }
+  frames[pos].dirty = false;
   available.push_back(pos);
 }
 
-void BufferPool::flushPage(const PageId &pid) {
+void BufferPool::Shard::writeFrames(std::vector<size_t> &positions) {
+  // One batch per file, in page order so that adjacent pages can be merged
+  std::sort(positions.begin(), positions.end(), [this](size_t a, size_t b) {
+    return std::tie(frames[a].pid.file, frames[a].pid.page) < std::tie(frames[b].pid.file, frames[b].pid.page);
+  });
+  std::vector<const Page *> batch;
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < positions.size(); i++) {
+    const PageId &pid = frames[positions[i]].pid;
+    batch.push_back(&pages[positions[i]]);
+    ids.push_back(pid.page);
+    if (i + 1 == positions.size() || frames[positions[i + 1]].pid.file != pid.file) {
+      getDatabase().get(pid.file).writePages(batch, ids);
+      batch.clear();
+      ids.clear();
+    }
+  }
+  for (size_t pos : positions) {
+    frames[pos].dirty = false;
+  }
+}
+
+bool BufferPool::Shard::flushPage(const PageId &pid) {
   size_t pos = pid_to_pos.at(pid);
-  if (dirty.erase(pos) == 0)
-    return;
+  if (!frames[pos].dirty)
+    return false;
+  frames[pos].dirty = false;
   const Page &page = pages[pos];
   getDatabase().get(pid.file).writePage(page, pid.page);
+  return true;
 }
 
-void BufferPool::flushFile(const std::string &file) {
-  std::vector<size_t> to_flush;
-  for (const size_t &pos : dirty) {
-    const PageId &pid = pos_to_pid[pos];
-    if (pid.file == file) {
-      to_flush.emplace_back(pid.page);
+BufferPool::BufferPool(const BufferPoolConfig &config)
+    : config(config), pages_bytes(config.num_pages * DEFAULT_PAGE_SIZE) {
+  if (config.num_pages == 0) {
+    throw std::invalid_argument("Buffer pool must have at least one page");
+  }
+  if (config.num_shards == 0 || config.num_shards > config.num_pages) {
+    throw std::invalid_argument("Buffer pool must have between one shard and one shard per page");
+  }
+  pages = mapFrames(pages_bytes, config.huge_pages);
+
+  // Split the frames evenly, the first `num_pages % num_shards` shards get one extra frame
+  size_t base = 0;
+  shards.reserve(config.num_shards);
+  for (size_t i = 0; i < config.num_shards; i++) {
+    size_t count = config.num_pages / config.num_shards + (i < config.num_pages % config.num_shards);
+    shards.push_back(std::make_unique<Shard>(i, pages + base, count, config));
+    base += count;
+  }
+
+  IoEngine::setDefault(config.io_engine, config.io_depth);
+
+  if (config.read_ahead_pages > 0) {
+    prefetcher = std::make_unique<Prefetcher>(
+        [this](const std::vector<PrefetchRequest> &requests) { return loadAhead(requests); }, config.io_depth);
+    for (const auto &shard : shards) {
+      shard->prefetcher = prefetcher.get();
+    }
+  }
+
+  if (config.writer_clean_fraction > 0) {
+    writer_started = std::chrono::steady_clock::now();
+    writer = std::thread(&BufferPool::runWriter, this);
+  }
+}
+
+BufferPool::~BufferPool() {
+  // Stop the background threads before the frames go away
+  if (writer.joinable()) {
+    {
+      std::lock_guard lock(writer_latch);
+      writer_stopping = true;
+    }
+    writer_wakeup.notify_all();
+    writer.join();
+  }
+  prefetcher.reset();
+  for (const auto &shard : shards) {
+    for (size_t pos = 0; pos < shard->num_frames; pos++) {
+      if (shard->frames[pos].dirty) {
+        const PageId &pid = shard->frames[pos].pid;
+        getDatabase().get(pid.file).writePage(shard->pages[pos], pid.page);
+      }
     }
   }
-  for (const auto &page : to_flush) {
-    flushPage({file, page});
+  munmap(pages, pages_bytes);
+}
+
+BufferPool::Shard &BufferPool::shardOf(const PageId &pid) const {
+  if (shards.size() == 1) {
+    return *shards.front();
+  }
+  return *shards[shardIndex(pid, shards.size())];
+}
+
+size_t BufferPool::shardIndex(const PageId &pid, size_t num_shards) {
+  return (std::hash<const PageId>()(pid) >> 32) % num_shards;
+}
+
+const BufferPoolConfig &BufferPool::getConfig() const { return config; }
+
+size_t BufferPool::getNumPages() const { return config.num_pages; }
+
+size_t BufferPool::getNumShards() const { return shards.size(); }
+
+Page &BufferPool::getPage(const PageId &pid) {
+  Shard &shard = shardOf(pid);
+  std::unique_lock lock(shard.latch);
+  return shard.pages[shard.fetch(lock, pid)];
+}
+
+PageGuard BufferPool::fetchPage(const PageId &pid, ScanRing *ring) {
+  Shard &shard = shardOf(pid);
+  std::unique_lock lock(shard.latch);
+  size_t pos = shard.fetch(lock, pid, ring);
+  shard.frames[pos].pins.fetch_add(1, std::memory_order_relaxed);
+  return {&shard, pos, pid};
+}
+
+std::shared_ptr<ScanRing> BufferPool::makeScanRing() {
+  if (config.scan_ring_pages == 0) {
+    return nullptr;
+  }
+  return std::make_shared<ScanRing>(*this, std::max<size_t>(1, config.scan_ring_pages / shards.size()));
+}
+
+std::shared_ptr<ReadAhead> BufferPool::makeReadAhead(const DbFile &file) {
+  if (!prefetcher) {
+    return nullptr;
+  }
+  return std::make_shared<ReadAhead>(*this, file, config.read_ahead_pages);
+}
+
+void BufferPool::prefetch(PrefetchRequest request) {
+  if (prefetcher) {
+    prefetcher->submit(std::move(request));
+  }
+}
+
+void BufferPool::cancelPrefetch(const DbFile &file) {
+  if (prefetcher) {
+    prefetcher->cancel(file);
+  }
+}
+
+PrefetchStats BufferPool::getPrefetchStats() const {
+  PrefetchStats stats;
+  for (const auto &shard : shards) {
+    std::lock_guard lock(shard->latch);
+    stats.issued += shard->prefetch_stats.issued;
+    stats.hits += shard->prefetch_stats.hits;
+    stats.misses += shard->prefetch_stats.misses;
+    stats.wasted += shard->prefetch_stats.wasted;
+  }
+  return stats;
+}
+
+BufferPoolStats BufferPool::collectStats(bool reset) {
+  BufferPoolStats stats;
+  std::vector<BufferPoolCounters> by_id;
+  for (const auto &shard : shards) {
+    std::lock_guard lock(shard->latch);
+    if (by_id.size() < shard->stats.size()) {
+      by_id.resize(shard->stats.size());
+    }
+    for (size_t file = 0; file < shard->stats.size(); file++) {
+      by_id[file] += shard->stats[file];
+    }
+    if (reset) {
+      shard->stats.clear();
+    }
+  }
+  for (size_t file = 0; file < by_id.size(); file++) {
+    const BufferPoolCounters &counters = by_id[file];
+    if (counters.hits + counters.misses + counters.evictions + counters.flushes == 0) {
+      continue;
+    }
+    stats.total += counters;
+    stats.files[getDatabase().getFileName(file)] = counters;
+  }
+  return stats;
+}
+
+BufferPoolStats BufferPool::getStats() { return collectStats(false); }
+
+BufferPoolStats BufferPool::resetStats() { return collectStats(true); }
+
+WriterStats BufferPool::getWriterStats() const {
+  WriterStats stats{written_pages.load(std::memory_order_relaxed), write_calls.load(std::memory_order_relaxed)};
+  if (writer.joinable()) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - writer_started;
+    stats.pages_per_second = static_cast<double>(stats.pages) / elapsed.count();
+  }
+  return stats;
+}
+
+PageGuard BufferPool::fetchPage(const PageId &pid, bool dirty) {
+  Shard &shard = shardOf(pid);
+  std::unique_lock lock(shard.latch);
+  size_t pos = shard.fetch(lock, pid);
+  shard.frames[pos].pins.fetch_add(1, std::memory_order_relaxed);
+  if (dirty) {
+    shard.frames[pos].dirty = true;
+  }
+  return {&shard, pos, pid};
+}
+
+void BufferPool::markDirty(const PageId &pid) {
+  Shard &shard = shardOf(pid);
+  std::lock_guard lock(shard.latch);
+  shard.frames[shard.pid_to_pos.at(pid)].dirty = true;
+}
+
+bool BufferPool::isDirty(const PageId &pid) const {
+  const Shard &shard = shardOf(pid);
+  std::lock_guard lock(shard.latch);
+  return shard.frames[shard.pid_to_pos.at(pid)].dirty;
+}
+
+PageGuard BufferPool::fetchResident(const PageId &pid) {
+  Shard &shard = shardOf(pid);
+  std::unique_lock lock(shard.latch);
+  size_t pos = shard.pid_to_pos.find(pid);
+  while (pos == PageTable::npos && shard.writing.contains(pid)) {
+    // Evicted while the background writer writes it back: the contents on disk are not current yet
+    shard.io_done.wait(lock, [&] { return !shard.writing.contains(pid); });
+    pos = shard.pid_to_pos.find(pid);
+  }
+  if (pos == PageTable::npos) {
+    return {};
+  }
+  shard.frames[pos].pins.fetch_add(1, std::memory_order_relaxed);
+  return {&shard, pos, pid};
+}
+
+bool BufferPool::contains(const PageId &pid) const {
+  const Shard &shard = shardOf(pid);
+  std::lock_guard lock(shard.latch);
+  return shard.pid_to_pos.contains(pid);
+}
+
+void BufferPool::discardPage(const PageId &pid) {
+  Shard &shard = shardOf(pid);
+  std::lock_guard lock(shard.latch);
+  shard.discardPage(pid);
+}
+
+void BufferPool::flushPage(const PageId &pid) {
+  Shard &shard = shardOf(pid);
+  std::unique_lock lock(shard.latch);
+  // An older copy that the background writer is writing back must not land after this one
+  shard.io_done.wait(lock, [&] { return !shard.writing.contains(pid); });
+  if (shard.flushPage(pid)) {
+    shard.statsOf(pid.file).flushes++;
+  }
+}
+
+void BufferPool::flushFile(const std::string &name) {
+  file_id_t file = getDatabase().getFileId(name);
+  for (const auto &shard : shards) {
+    std::unique_lock lock(shard->latch);
+    // Wait for the pages the background writer is writing back: they are only on disk once the writes complete, and
+    // newer copies must not be written before them
+    shard->io_done.wait(lock, [&] {
+      return std::none_of(shard->writing.begin(), shard->writing.end(),
+                          [&](const auto &entry) { return entry.first.file == file; });
+    });
+    std::vector<size_t> positions;
+    for (size_t pos = 0; pos < shard->num_frames; pos++) {
+      if (shard->frames[pos].dirty && shard->frames[pos].pid.file == file) {
+        positions.push_back(pos);
+      }
+    }
+    shard->writeFrames(positions);
+    if (!positions.empty()) {
+      shard->statsOf(file).flushes += positions.size();
+    }
+  }
+}
+
+void BufferPool::discardFile(const std::string &name) {
+  file_id_t file = getDatabase().getFileId(name);
+  for (const auto &shard : shards) {
+    std::unique_lock lock(shard->latch);
+    shard->io_done.wait(lock, [&] {
+      return std::none_of(shard->writing.begin(), shard->writing.end(),
+                          [&](const auto &entry) { return entry.first.file == file; });
+    });
+    for (size_t pos = 0; pos < shard->num_frames; pos++) {
+      // An empty frame has the id of page 0 of file 0
+      const PageId pid = shard->frames[pos].pid;
+      if (pid.file == file && shard->pid_to_pos.find(pid) == pos) {
+        shard->discardPage(pid);
+      }
+    }
+  }
+}
+
+std::vector<PrefetchRequest> BufferPool::loadAhead(const std::vector<PrefetchRequest> &requests) {
+  struct Load {
+    const PrefetchRequest *request;
+    Shard *shard;
+    size_t pos;
+    bool read;
+  };
+  std::vector<Load> loads;
+  for (const PrefetchRequest &request : requests) {
+    Shard &shard = shardOf(request.pid);
+    std::lock_guard lock(shard.latch);
+    if (size_t pos = shard.pid_to_pos.find(request.pid); pos != PageTable::npos) {
+      // Resident pages are not read, but a chain continues from them
+      loads.push_back({&request, &shard, pos, false});
+    } else if (!shard.loading.contains(request.pid) && !shard.writing.contains(request.pid)) {
+      // A page that is being written back could be read with the contents from before the write
+      try {
+        size_t pos = shard.allocate();
+        shard.loading[request.pid] = pos;
+        loads.push_back({&request, &shard, pos, true});
+      } catch (const std::runtime_error &) {
+        // Every frame of the shard is pinned
+      }
+    }
+  }
+
+  // Read the reserved frames without the latches, one batch per file
+  std::sort(loads.begin(), loads.end(), [](const Load &a, const Load &b) {
+    return std::tie(a.request->file, a.request->pid.page) < std::tie(b.request->file, b.request->pid.page);
+  });
+  std::vector<Page *> batch;
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < loads.size(); i++) {
+    if (loads[i].read) {
+      batch.push_back(&loads[i].shard->pages[loads[i].pos]);
+      ids.push_back(loads[i].request->pid.page);
+    }
+    if (!batch.empty() && (i + 1 == loads.size() || loads[i + 1].request->file != loads[i].request->file)) {
+      loads[i].request->file->readPages(batch, ids);
+      batch.clear();
+      ids.clear();
+    }
+  }
+
+  std::vector<PrefetchRequest> next;
+  for (const Load &load : loads) {
+    const PrefetchRequest &request = *load.request;
+    Shard &shard = *load.shard;
+    std::lock_guard lock(shard.latch);
+    if (load.read) {
+      shard.loading.erase(request.pid);
+      shard.pid_to_pos.insert(request.pid, load.pos);
+      shard.frames[load.pos].pid = request.pid;
+      shard.policy->insert(load.pos, std::hash<const PageId>()(request.pid));
+      shard.frames[load.pos].prefetched = true;
+      shard.prefetch_stats.issued++;
+      shard.io_done.notify_all();
+    }
+    // The frame of a resident page may have been reused since it was looked up
+    if (request.remaining == 0 || shard.frames[load.pos].pid != request.pid) {
+      continue;
+    }
+    size_t page = request.successor ? request.successor(shard.pages[load.pos]) : request.pid.page + 1;
+    if (page != PrefetchRequest::npos) {
+      next.push_back({request.file, {request.pid.file, page}, request.remaining - 1, request.successor});
+    }
+  }
+  return next;
+}
+
+void BufferPool::runWriter() {
+  std::unique_lock lock(writer_latch);
+  size_t first = 0;
+  while (!writer_wakeup.wait_for(lock, config.writer_interval, [this] { return writer_stopping; })) {
+    lock.unlock();
+    // Start from a different shard every round, so a small budget is spread over all of them
+    size_t budget = config.writer_max_pages;
+    for (size_t i = 0; i < shards.size() && budget > 0; i++) {
+      budget -= writeBack(*shards[(first + i) % shards.size()], budget);
+    }
+    first = (first + 1) % shards.size();
+    lock.lock();
+  }
+}
+
+size_t BufferPool::writeBack(Shard &shard, size_t budget) {
+  struct Pending {
+    PageId pid;
+    const DbFile *file;
+    size_t copy;
+  };
+  std::vector<size_t> cold;
+  // Aligned, so that the copies can be written with direct I/O
+  std::vector<AlignedPage> copies;
+  std::vector<Pending> pending;
+  {
+    std::lock_guard lock(shard.latch);
+    size_t target = std::ceil(config.writer_clean_fraction * static_cast<double>(shard.num_frames));
+    shard.policy->coldest(target, cold);
+    copies.reserve(std::min(budget, cold.size()));
+    for (size_t pos : cold) {
+      if (pending.size() == budget) {
+        break;
+      }
+      // Pinned pages are likely being modified, they are written once they are released
+      if (!shard.frames[pos].dirty || shard.frames[pos].pins.load(std::memory_order_acquire) != 0) {
+        continue;
+      }
+      const PageId &pid = shard.frames[pos].pid;
+      const DbFile *file;
+      try {
+        file = &getDatabase().get(pid.file);
+      } catch (const std::out_of_range &) {
+        continue;
+      }
+      copies.push_back({shard.pages[pos]});
+      pending.push_back({pid, file, copies.size() - 1});
+      shard.frames[pos].dirty = false;
+      shard.writing[pid] = pos;
+    }
+  }
+  if (pending.empty()) {
+    return 0;
+  }
+
+  // One batch per file, in page order so that adjacent pages can be merged
+  std::sort(pending.begin(), pending.end(), [](const Pending &a, const Pending &b) {
+    return std::tie(a.pid.file, a.pid.page) < std::tie(b.pid.file, b.pid.page);
+  });
+  std::vector<const Page *> batch;
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < pending.size(); i++) {
+    batch.push_back(&copies[pending[i].copy].page);
+    ids.push_back(pending[i].pid.page);
+    if (i + 1 == pending.size() || pending[i + 1].file != pending[i].file) {
+      pending[i].file->writePages(batch, ids);
+      write_calls.fetch_add(1, std::memory_order_relaxed);
+      batch.clear();
+      ids.clear();
+    }
+  }
+  written_pages.fetch_add(pending.size(), std::memory_order_relaxed);
+
+  {
+    std::lock_guard lock(shard.latch);
+    for (const Pending &p : pending) {
+      shard.writing.erase(p.pid);
+    }
+  }
+  shard.io_done.notify_all();
+  return pending.size();
+}
+
+ScanRing::ScanRing(BufferPool &pool, size_t frames_per_shard)
+    : pool(pool), frames_per_shard(frames_per_shard), frames(pool.shards.size()), cursor(pool.shards.size()) {}
+
+ScanRing::~ScanRing() {
+  // Hand the pages back to the replacement policies as the next eviction candidates
+  for (auto &shard : pool.shards) {
+    std::lock_guard lock(shard->latch);
+    for (size_t pos : frames[shard->index]) {
+      if (shard->frames[pos].ring_owner == this) {
+        shard->frames[pos].ring_owner = nullptr;
+        shard->policy->insert(pos, std::hash<const PageId>()(shard->frames[pos].pid));
+        shard->policy->demote(pos);
+      }
+    }
+  }
+}
+
+PageGuard::PageGuard(BufferPool::Shard *shard, size_t pos, const PageId &pid)
+    : shard(shard), pos(pos), page(&shard->pages[pos]), pid(pid) {}
+
+PageGuard::PageGuard(const Page *page, const PageId &pid) : page(const_cast<Page *>(page)), pid(pid) {}
+
+PageGuard::PageGuard(const PageGuard &other) : shard(other.shard), pos(other.pos), page(other.page), pid(other.pid) {
+  // The source already holds a pin, so the frame cannot be evicted while we add ours
+  if (shard) {
+    shard->frames[pos].pins.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+PageGuard::PageGuard(PageGuard &&other) noexcept
+    : shard(std::exchange(other.shard, nullptr)), pos(other.pos), page(std::exchange(other.page, nullptr)),
+      pid(std::move(other.pid)) {}
+
+PageGuard &PageGuard::operator=(const PageGuard &other) {
+  if (this != &other) {
+    *this = PageGuard(other);
+  }
+  return *this;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    shard = std::exchange(other.shard, nullptr);
+    pos = other.pos;
+    page = std::exchange(other.page, nullptr);
+    pid = std::move(other.pid);
+  }
+  return *this;
+}
+
+PageGuard::~PageGuard() { release(); }
+
+void PageGuard::markDirty() {
+  if (!shard) {
+    throw std::logic_error("Mapped pages are read-only");
+  }
+  std::lock_guard lock(shard->latch);
+  shard->frames[pos].dirty = true;
+}
+
+void PageGuard::release() {
+  if (shard) {
+    shard->frames[pos].pins.fetch_sub(1, std::memory_order_release);
+    shard = nullptr;
   }
+  page = nullptr;
 }
@@ -2,7 +2,19 @@
 
 using namespace db;
 
-BufferPool &Database::getBufferPool() { return bufferPool; }
+Database::Database() : bufferPool(std::make_unique<BufferPool>()) {}
+
+BufferPool &Database::getBufferPool() { return *bufferPool; }
+
+void Database::configureBufferPool(const BufferPoolConfig &config) {
+  // Build the new pool first so a failed allocation leaves the current one in place
+  auto pool = std::make_unique<BufferPool>(config);
+  bufferPool = std::move(pool);
+  std::shared_lock lock(latch);
+  for (auto &[name, file] : files) {
+    file->setDirectIo(config.direct_io);
+  }
+}
 
 Database &db::getDatabase() {
   static Database instance;
@@ -11,19 +23,74 @@ Database &db::getDatabase() {
 
 void Database::add(std::unique_ptr<DbFile> file) {
   const std::string &name = file->getName();
+  std::unique_lock lock(latch);
   if (files.contains(name)) {
     throw std::logic_error("File already exists");
   }
+  if (bufferPool->getConfig().direct_io) {
+    file->setDirectIo(true);
+  }
+  by_id[file->getId()] = file.get();
   files[name] = std::move(file);
 }
 
 std::unique_ptr<DbFile> Database::remove(const std::string &name) {
-  auto nh = files.extract(name);
-  if (nh.empty()) {
+  DbFile *file;
+  {
+    std::shared_lock lock(latch);
+    auto it = files.find(name);
+    if (it == files.end()) {
+      throw std::logic_error("File does not exist");
+    }
+    file = it->second.get();
+  }
+  // Write the pages back while the file can still be looked up by the buffer pool, then drop them so that a file added
+  // later under the same name and id does not see them
+  Database::getBufferPool().cancelPrefetch(*file);
+  Database::getBufferPool().flushFile(name);
+  Database::getBufferPool().discardFile(name);
+  std::unique_lock lock(latch);
+  // The file may have been removed while the latch was released
+  auto it = files.find(name);
+  if (it == files.end()) {
     throw std::logic_error("File does not exist");
   }
-  Database::getBufferPool().flushFile(nh.key());
-  return std::move(nh.mapped());
+  by_id[it->second->getId()] = nullptr;
+  return std::move(files.extract(it).mapped());
+}
+
+DbFile &Database::get(const std::string &name) const {
+  std::shared_lock lock(latch);
+  return *files.at(name);
+}
+
+DbFile &Database::get(file_id_t id) const {
+  std::shared_lock lock(latch);
+  if (id >= by_id.size() || !by_id[id]) {
+    throw std::out_of_range("File does not exist");
+  }
+  return *by_id[id];
+}
+
+file_id_t Database::getFileId(const std::string &name) {
+  {
+    std::shared_lock lock(latch);
+    if (auto it = ids.find(name); it != ids.end()) {
+      return it->second;
+    }
+  }
+  std::unique_lock lock(latch);
+  auto [it, inserted] = ids.try_emplace(name, static_cast<file_id_t>(by_id.size()));
+  if (inserted) {
+    by_id.push_back(nullptr);
+    names.push_back(name);
+  }
+  return it->second;
+}
+
+std::string Database::getFileName(file_id_t id) const {
+  std::shared_lock lock(latch);
+  return names.at(id);
 }
 
-DbFile &Database::get(const std::string &name) const { return *files.at(name); }
+PageId::PageId(const std::string &name, size_t page) : file(getDatabase().getFileId(name)), page(page) {}
@@ -1,6 +1,11 @@
+#include <chrono>
+#include <cstring>
+#include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <db/IoEngine.hpp>
 #include <stdexcept>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -8,7 +13,8 @@ using namespace db;
 
 const TupleDesc &DbFile::getTupleDesc() const { return td; }
 
-DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td) {
+DbFile::DbFile(const std::string &name, const TupleDesc &td)
+    : name(name), td(td), id(getDatabase().getFileId(name)) {
   fd = open(name.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
   if (fd == -1) {
     throw std::runtime_error("open");
@@ -24,25 +30,193 @@ DbFile::DbFile(const std::string &name, const TupleDesc &td) : name(name), td(td
 }
 
 DbFile::~DbFile() {
+  unmap();
   close(fd);
 }
 
 const std::string &DbFile::getName() const { return name; }
 
+file_id_t DbFile::getId() const { return id; }
+
+bool DbFile::setDirectIo(bool enable) {
+  if (enable == direct.load()) {
+    return enable;
+  }
+  int flags = fcntl(fd, F_GETFL);
+  if (flags == -1) {
+    throw std::runtime_error("fcntl");
+  }
+  if (enable) {
+    // Bounce unaligned buffers before the flag is set, some filesystems reject O_DIRECT altogether
+    direct = true;
+    if (fcntl(fd, F_SETFL, flags | O_DIRECT) == -1) {
+      direct = false;
+      return false;
+    }
+    // The pages cached so far would stay in memory next to their frames
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    return true;
+  }
+  if (fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+    throw std::runtime_error("fcntl");
+  }
+  direct = false;
+  return false;
+}
+
+bool DbFile::isDirectIo() const { return direct.load(); }
+
+bool DbFile::map(AccessPattern pattern) {
+  unmap();
+  struct stat st{};
+  if (fstat(fd, &st) == -1) {
+    throw std::runtime_error("fstat");
+  }
+  size_t pages = st.st_size / DEFAULT_PAGE_SIZE;
+  if (pages == 0) {
+    return false;
+  }
+  void *mem = mmap(nullptr, pages * DEFAULT_PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  mapping = static_cast<const Page *>(mem);
+  mapped_pages = pages;
+  advise(pattern);
+  return true;
+}
+
+void DbFile::unmap() {
+  if (mapping) {
+    munmap(const_cast<Page *>(mapping), mapped_pages * DEFAULT_PAGE_SIZE);
+    mapping = nullptr;
+    mapped_pages = 0;
+  }
+}
+
+bool DbFile::isMapped() const { return mapping != nullptr; }
+
+void DbFile::advise(AccessPattern pattern) const {
+  if (!mapping) {
+    return;
+  }
+  int advice = MADV_NORMAL;
+  if (pattern == AccessPattern::SEQUENTIAL) {
+    advice = MADV_SEQUENTIAL;
+  } else if (pattern == AccessPattern::RANDOM) {
+    advice = MADV_RANDOM;
+  }
+  // Only a hint: a kernel that ignores it still serves the faults
+  madvise(const_cast<Page *>(mapping), mapped_pages * DEFAULT_PAGE_SIZE, advice);
+}
+
+PageGuard DbFile::fetchForRead(size_t page, ScanRing *ring) const {
+  BufferPool &bufferPool = getDatabase().getBufferPool();
+  if (page >= mapped_pages) {
+    return bufferPool.fetchPage({id, page}, ring);
+  }
+  if (PageGuard guard = bufferPool.fetchResident({id, page})) {
+    return guard;
+  }
+  return {&mapping[page], {id, page}};
+}
+
+void DbFile::submit(std::vector<IoRequest> &requests) const {
+  if (!direct.load(std::memory_order_relaxed)) {
+    IoEngine::local().submit(requests);
+    return;
+  }
+  std::vector<size_t> unaligned;
+  for (size_t i = 0; i < requests.size(); i++) {
+    if (reinterpret_cast<uintptr_t>(requests[i].data) % DIRECT_IO_ALIGNMENT != 0) {
+      unaligned.push_back(i);
+    }
+  }
+  std::vector<AlignedPage> bounce(unaligned.size());
+  std::vector<uint8_t *> original(unaligned.size());
+  for (size_t i = 0; i < unaligned.size(); i++) {
+    IoRequest &request = requests[unaligned[i]];
+    original[i] = request.data;
+    if (request.op == IoRequest::Op::WRITE) {
+      std::memcpy(bounce[i].page.data(), request.data, request.length);
+    }
+    request.data = bounce[i].page.data();
+  }
+  IoEngine::local().submit(requests);
+  for (size_t i = 0; i < unaligned.size(); i++) {
+    if (requests[unaligned[i]].op == IoRequest::Op::READ) {
+      std::memcpy(original[i], bounce[i].page.data(), requests[unaligned[i]].length);
+    }
+  }
+}
+
+void DbFile::read(std::vector<IoRequest> &requests, const std::vector<size_t> &ids) const {
+  auto begin = std::chrono::steady_clock::now();
+  submit(requests);
+  read_latency.record(std::chrono::steady_clock::now() - begin);
+  pages_read.fetch_add(ids.size(), std::memory_order_relaxed);
+  reads.record(ids);
+}
+
+void DbFile::write(std::vector<IoRequest> &requests, const std::vector<size_t> &ids) const {
+  auto begin = std::chrono::steady_clock::now();
+  submit(requests);
+  write_latency.record(std::chrono::steady_clock::now() - begin);
+  pages_written.fetch_add(ids.size(), std::memory_order_relaxed);
+  writes.record(ids);
+}
+
 void DbFile::readPage(Page &page, const size_t id) const {
-  reads.push_back(id);
   std::fill(page.begin(), page.end(), 0);
-  pread(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+  std::vector<IoRequest> requests{{IoRequest::Op::READ, fd, page.data(), DEFAULT_PAGE_SIZE, offset(id)}};
+  read(requests, {id});
 }
 
 void DbFile::writePage(const Page &page, const size_t id) const {
-  writes.push_back(id);
-  pwrite(fd, page.data(), DEFAULT_PAGE_SIZE, id * DEFAULT_PAGE_SIZE);
+  std::vector<IoRequest> requests{
+      {IoRequest::Op::WRITE, fd, const_cast<uint8_t *>(page.data()), DEFAULT_PAGE_SIZE, offset(id)}};
+  write(requests, {id});
 }
 
-const std::vector<size_t> &DbFile::getReads() const { return reads; }
+void DbFile::readPages(const std::vector<Page *> &pages, const std::vector<size_t> &ids) const {
+  std::vector<IoRequest> requests;
+  requests.reserve(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    std::fill(pages[i]->begin(), pages[i]->end(), 0);
+    requests.push_back({IoRequest::Op::READ, fd, pages[i]->data(), DEFAULT_PAGE_SIZE, offset(ids[i])});
+  }
+  read(requests, ids);
+}
 
-const std::vector<size_t> &DbFile::getWrites() const { return writes; }
+void DbFile::writePages(const std::vector<const Page *> &pages, const std::vector<size_t> &ids) const {
+  std::vector<IoRequest> requests;
+  requests.reserve(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    auto *data = const_cast<uint8_t *>(pages[i]->data());
+    requests.push_back({IoRequest::Op::WRITE, fd, data, DEFAULT_PAGE_SIZE, offset(ids[i])});
+  }
+  write(requests, ids);
+}
+
+const IoTrace &DbFile::getReads() const { return reads; }
+
+const IoTrace &DbFile::getWrites() const { return writes; }
+
+void DbFile::setTraceCapacity(size_t capacity) {
+  reads.reset(capacity);
+  writes.reset(capacity);
+}
+
+IoStats DbFile::getIoStats() const {
+  IoStats stats;
+  stats.pages_read = pages_read.load(std::memory_order_relaxed);
+  stats.pages_written = pages_written.load(std::memory_order_relaxed);
+  stats.bytes_read = stats.pages_read * DEFAULT_PAGE_SIZE;
+  stats.bytes_written = stats.pages_written * DEFAULT_PAGE_SIZE;
+  stats.read_latency = read_latency.snapshot();
+  stats.write_latency = write_latency.snapshot();
+  return stats;
+}
 
 void DbFile::insertTuple(const Tuple &t) { throw std::runtime_error("Not implemented"); }
 
@@ -50,10 +224,29 @@ void DbFile::deleteTuple(const Iterator &it) { throw std::runtime_error("Not imp
 
 Tuple DbFile::getTuple(const Iterator &it) const { throw std::runtime_error("Not implemented"); }
 
+void DbFile::insertRow(const uint8_t *row) { insertTuple(td.deserialize(row)); }
+
+TupleView DbFile::getTupleView(Iterator &it) const { throw std::runtime_error("Not implemented"); }
+
 void DbFile::next(Iterator &it) const { throw std::runtime_error("Not implemented"); }
 
+bool DbFile::nextBatch(Iterator &it, PageBatch &batch, size_t max_rows) const {
+  throw std::runtime_error("Not implemented");
+}
+
 Iterator DbFile::begin() const { throw std::runtime_error("Not implemented"); }
 
 Iterator DbFile::end() const { throw std::runtime_error("Not implemented"); }
 
+Iterator DbFile::scan(std::vector<size_t> projection) const {
+  for (size_t index : projection) {
+    if (index >= td.size()) {
+      throw std::out_of_range("Projected field does not exist");
+    }
+  }
+  Iterator it = begin();
+  it.projection = std::move(projection);
+  return it;
+}
+
 size_t DbFile::getNumPages() const { return numPages; }
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <db/FreeSpaceMap.hpp>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+using namespace db;
+
+uint8_t FreeSpaceMap::classify(size_t free, size_t capacity) {
+  if (free == 0 || capacity == 0) {
+    return FULL;
+  }
+  return static_cast<uint8_t>(std::min(free, capacity) * EMPTY / capacity);
+}
+
+size_t FreeSpaceMap::size() const { return classes.size(); }
+
+uint8_t FreeSpaceMap::get(size_t page) const { return page < classes.size() ? classes[page] : FULL; }
+
+void FreeSpaceMap::set(size_t page, uint8_t cls) {
+  if (page >= classes.size()) {
+    classes.resize(page + 1, FULL);
+  }
+  classes[page] = cls;
+  // The page may now have room for searches whose cursor is past it
+  for (size_t c = 1; c <= cls; c++) {
+    cursors[c] = std::min(cursors[c], page);
+  }
+}
+
+size_t FreeSpaceMap::find(uint8_t cls, size_t from) {
+  size_t &cursor = cursors[std::max<uint8_t>(cls, 1)];
+  size_t page = std::max(cursor, from);
+  while (page < classes.size() && classes[page] < cls) {
+    page++;
+  }
+  // The pages passed over from the cursor are too full for every search of this class
+  if (from <= cursor) {
+    cursor = page;
+  }
+  return page < classes.size() ? page : npos;
+}
+
+void FreeSpaceMap::clear() {
+  classes.clear();
+  cursors.fill(0);
+}
+
+bool FreeSpaceMap::load(const std::string &path, const std::string &data) {
+  clear();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st{};
+  struct stat data_st{};
+  bool ok = fstat(fd, &st) == 0 && stat(data.c_str(), &data_st) == 0 &&
+            std::tie(st.st_mtim.tv_sec, st.st_mtim.tv_nsec) >= std::tie(data_st.st_mtim.tv_sec, data_st.st_mtim.tv_nsec);
+  if (ok) {
+    classes.resize(st.st_size);
+    ok = read(fd, classes.data(), classes.size()) == static_cast<ssize_t>(classes.size());
+  }
+  close(fd);
+  if (!ok) {
+    clear();
+  }
+  return ok;
+}
+
+bool FreeSpaceMap::save(const std::string &path) const {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd == -1) {
+    return false;
+  }
+  bool ok = write(fd, classes.data(), classes.size()) == static_cast<ssize_t>(classes.size());
+  return close(fd) == 0 && ok;
+}
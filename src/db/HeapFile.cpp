@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <db/Database.hpp>
 #include <db/HeapFile.hpp>
 #include <db/HeapPage.hpp>
@@ -5,82 +6,298 @@
 
 using namespace db;
 
-HeapFile::HeapFile(const std::string &name, const TupleDesc &td) : DbFile(name, td) {}
+HeapFile::HeapFile(const std::string &name, const TupleDesc &td, PageLayout layout)
+    : DbFile(name, td), layout(td.is_fixed() ? layout : PageLayout::SLOTTED) {
+  if (!td.is_fixed() && layout == PageLayout::PAX) {
+    throw std::logic_error("PAX pages need fixed-length tuples");
+  }
+  // A saved map is read now, so that scans can skip empty pages, but rebuilding a missing one waits for an insert
+  fsm_loaded = fsm.load(name + ".fsm", name) && fsm.size() == numPages;
+  if (!fsm_loaded) {
+    fsm.clear();
+  }
+}
+
+PageLayout HeapFile::getLayout() const { return layout; }
+
+HeapFile::~HeapFile() {
+  if (fsm_loaded) {
+    fsm.save(name + ".fsm");
+  }
+}
+
+FreeSpaceMap &HeapFile::freeSpace() {
+  if (fsm_loaded) {
+    return fsm;
+  }
+  if (!fsm.load(name + ".fsm", name) || fsm.size() != numPages) {
+    fsm.clear();
+    for (size_t page = 0; page < numPages; page++) {
+      PageGuard p = fetchForRead(page);
+      const HeapPage hp(*p, td, layout);
+      fsm.set(page, hp.freeClass());
+    }
+  }
+  fsm_loaded = true;
+  return fsm;
+}
+
+bool HeapFile::skip(size_t page) const { return fsm_loaded && fsm.get(page) == FreeSpaceMap::EMPTY; }
+
+PageGuard HeapFile::pin(const Iterator &it, bool write) const {
+  // A page of the mapping cannot be modified, writes always go through the buffer pool
+  if (it.guard && it.guard.getPageId().page == it.page && !(write && it.guard.isMapped())) {
+    return it.guard;
+  }
+  return write ? getDatabase().getBufferPool().fetchPage({id, it.page}) : fetchForRead(it.page);
+}
+
+template <typename Insert> void HeapFile::insert(uint8_t cls, Insert &&insert) {
+  BufferPool &bufferPool = getDatabase().getBufferPool();
+  FreeSpaceMap &map = freeSpace();
+  for (size_t page = map.find(cls); page != FreeSpaceMap::npos; page = map.find(cls, page + 1)) {
+    PageGuard p = bufferPool.fetchPage({id, page});
+    HeapPage hp(*p, td, layout);
+    bool inserted = insert(hp);
+    // A page that turns out to be full was out of date in the map
+    map.set(page, hp.freeClass());
+    if (inserted) {
+      p.markDirty();
+      return;
+    }
+  }
+  PageGuard np = bufferPool.fetchPage({id, numPages}, true);
+  HeapPage nhp(*np, td, layout);
+  if (!insert(nhp)) {
+    // The frame of the page past the end of the file must not be written back, or reused when the file grows
+    np.release();
+    bufferPool.discardPage({id, numPages});
+    throw std::runtime_error("Tuple does not fit in a page");
+  }
+  map.set(numPages, nhp.freeClass());
+  numPages++;
+}
 
 void HeapFile::insertTuple(const Tuple &t) {
   if (!td.compatible(t)) {
     throw std::runtime_error("Tuple not compatible with TupleDesc");
   }
-  BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, 0};
-  pid.page = numPages - 1;
-  Page &p = bufferPool.getPage(pid);
-  HeapPage hp(p, td);
-  if (!hp.insertTuple(t)) {
-    numPages++;
-    pid.page++;
-    Page &np = bufferPool.getPage(pid);
-    HeapPage nhp(np, td);
-    nhp.insertTuple(t);
+  if (layout == PageLayout::SLOTTED) {
+    std::vector<uint8_t> row(td.length(t));
+    td.serialize(row.data(), t);
+    insertRow(row.data());
+    return;
   }
-  bufferPool.markDirty(pid);
+  insert(1, [&](HeapPage &hp) { return hp.insertTuple(t); });
+}
+
+void HeapFile::insertRow(const uint8_t *row) {
+  uint8_t cls = layout == PageLayout::SLOTTED ? HeapPage::requiredClass(td.length(row)) : 1;
+  insert(cls, [&](HeapPage &hp) { return hp.insertRow(row); });
 }
 
 void HeapFile::deleteTuple(const Iterator &it) {
-  BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &p = bufferPool.getPage(pid);
-  HeapPage hp(p, td);
-  bufferPool.markDirty(pid);
+  FreeSpaceMap &map = freeSpace();
+  PageGuard p = pin(it, true);
+  HeapPage hp(*p, td, layout);
+  p.markDirty();
   hp.deleteTuple(it.slot);
+  map.set(it.page, hp.freeClass());
 }
 
 Tuple HeapFile::getTuple(const Iterator &it) const {
-  BufferPool &bufferPool = getDatabase().getBufferPool();
-  PageId pid{name, it.page};
-  Page &p = bufferPool.getPage(pid);
-  HeapPage hp(p, td);
-  return hp.getTuple(it.slot);
+  PageGuard p = pin(it, false);
+  HeapPage hp(*p, td, layout);
+  return it.projection.empty() ? hp.getTuple(it.slot) : hp.getTuple(it.slot, it.projection);
+}
+
+TupleView HeapFile::getTupleView(Iterator &it) const {
+  if (!it.guard || it.guard.getPageId().page != it.page) {
+    it.guard = fetchForRead(it.page, it.ring.get());
+  }
+  const HeapPage hp(*it.guard, td, layout);
+  return hp.getView(it.slot);
 }
 
 void HeapFile::next(Iterator &it) const {
-  BufferPool &bufferPool = getDatabase().getBufferPool();
   if (it.page < numPages) {
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    const HeapPage hp(p, td);
+    if (!it.guard || it.guard.getPageId().page != it.page) {
+      it.guard = fetchForRead(it.page, it.ring.get());
+    }
+    const HeapPage hp(*it.guard, td, layout);
     hp.next(it.slot);
     if (it.slot != hp.end()) {
       return;
     }
     it.page++;
   }
+  it.guard.release();
   while (it.page < numPages) {
-    PageId pid{name, it.page};
-    Page &p = bufferPool.getPage(pid);
-    const HeapPage hp(p, td);
+    if (skip(it.page)) {
+      it.page++;
+      continue;
+    }
+    if (it.read_ahead) {
+      it.read_ahead->advance(it.page);
+    }
+    it.guard = fetchForRead(it.page, it.ring.get());
+    const HeapPage hp(*it.guard, td, layout);
     it.slot = hp.begin();
     if (it.slot != hp.end()) {
       return;
     }
+    it.guard.release();
     it.page++;
   }
   it.slot = 0;
 }
 
+bool HeapFile::nextBatch(Iterator &it, PageBatch &batch, size_t max_rows) const {
+  batch.clear();
+  while (it.page < numPages) {
+    if (skip(it.page)) {
+      it.guard.release();
+      it.page++;
+      it.slot = 0;
+      continue;
+    }
+    if (!it.guard || it.guard.getPageId().page != it.page) {
+      if (it.read_ahead) {
+        it.read_ahead->advance(it.page);
+      }
+      it.guard = fetchForRead(it.page, it.ring.get());
+    }
+    const HeapPage hp(*it.guard, td, layout);
+    size_t slot = it.slot;
+    if (slot < hp.end() && hp.empty(slot)) {
+      hp.next(slot);
+    }
+    for (; slot < hp.end() && batch.slots.size() < max_rows; hp.next(slot)) {
+      batch.slots.push_back(slot);
+    }
+    if (!batch.slots.empty()) {
+      batch.page = it.guard;
+      batch.td = &td;
+      batch.data = hp.getData();
+      batch.stride = td.length();
+      batch.capacity = layout == PageLayout::PAX ? hp.end() : 0;
+      batch.directory = hp.getDirectory();
+    }
+    if (slot < hp.end()) {
+      it.slot = slot;
+      return true;
+    }
+    it.guard.release();
+    it.page++;
+    it.slot = 0;
+    if (!batch.slots.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Iterator HeapFile::begin() const {
   BufferPool &bufferPool = getDatabase().getBufferPool();
+  // A full scan reads its pages through a ring so that it does not evict the rest of the pool
+  std::shared_ptr<ScanRing> ring = bufferPool.makeScanRing();
+  // Pages of a mapped file are read ahead by the kernel
+  std::shared_ptr<ReadAhead> read_ahead = isMapped() ? nullptr : bufferPool.makeReadAhead(*this);
   size_t page = 0;
   while (page < numPages) {
-    PageId pid{name, page};
-    Page &p = bufferPool.getPage(pid);
-    const HeapPage hp(p, td);
+    if (skip(page)) {
+      page++;
+      continue;
+    }
+    if (read_ahead) {
+      read_ahead->advance(page);
+    }
+    PageGuard p = fetchForRead(page, ring.get());
+    const HeapPage hp(*p, td, layout);
     size_t slot = hp.begin();
     if (slot != hp.end())
-      return {*this, page, slot};
+      return {*this, page, slot, std::move(p), std::move(ring), std::move(read_ahead)};
     page++;
   }
   return {*this, numPages, 0};
 }
 
 Iterator HeapFile::end() const { return {*this, numPages, 0}; }
+
+HeapLoader::HeapLoader(HeapFile &file, size_t batch_pages)
+    : file(file), batch(std::max<size_t>(1, batch_pages)), first(file.numPages) {
+  Page page{};
+  capacity = HeapPage(page, file.td, file.layout).end();
+  // An empty file still has one (empty) page, which is replaced
+  if (file.numPages == 1 && file.freeSpace().get(0) == FreeSpaceMap::EMPTY) {
+    first = 0;
+  }
+}
+
+HeapLoader::~HeapLoader() {
+  try {
+    finish();
+  } catch (const std::exception &) {
+  }
+}
+
+bool HeapLoader::add(const Tuple &t) {
+  HeapPage hp(batch[count - 1].page, file.td, file.layout);
+  if (file.layout == PageLayout::SLOTTED) {
+    return hp.insertTuple(t);
+  }
+  if (slot == capacity) {
+    return false;
+  }
+  hp.insertTuple(slot++, t);
+  return true;
+}
+
+void HeapLoader::append(const Tuple &t) {
+  if (!file.td.compatible(t)) {
+    throw std::runtime_error("Tuple not compatible with TupleDesc");
+  }
+  if (count == 0 || !add(t)) {
+    if (count == batch.size()) {
+      write();
+    }
+    batch[count++].page.fill(0);
+    slot = 0;
+    if (!add(t)) {
+      throw std::runtime_error("Tuple does not fit in a page");
+    }
+  }
+  tuples++;
+}
+
+void HeapLoader::finish() {
+  if (count > 0) {
+    write();
+  }
+}
+
+size_t HeapLoader::size() const { return tuples; }
+
+void HeapLoader::write() {
+  BufferPool &bufferPool = getDatabase().getBufferPool();
+  FreeSpaceMap &map = file.freeSpace();
+  std::vector<const Page *> pages;
+  std::vector<size_t> ids;
+  for (size_t i = 0; i < count; i++) {
+    PageId pid{file.id, first + i};
+    // A frame of the page would hide the written contents
+    if (bufferPool.contains(pid)) {
+      bufferPool.discardPage(pid);
+    }
+    pages.push_back(&batch[i].page);
+    ids.push_back(pid.page);
+  }
+  file.writePages(pages, ids);
+  for (size_t i = 0; i < count; i++) {
+    map.set(first + i, HeapPage(batch[i].page, file.td, file.layout).freeClass());
+  }
+  first += count;
+  file.numPages = first;
+  count = 0;
+  slot = 0;
+}
@@ -1,40 +1,169 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <db/Database.hpp>
+#include <db/FreeSpaceMap.hpp>
 #include <db/HeapPage.hpp>
 #include <stdexcept>
 
 using namespace db;
 
-HeapPage::HeapPage(Page &page, const TupleDesc &td) : td(td) {
+HeapPage::HeapPage(Page &page, const TupleDesc &td, PageLayout layout) : td(td), layout(layout) {
+  if (layout == PageLayout::SLOTTED) {
+    header = page.data();
+    data = header;
+    slot_header = reinterpret_cast<SlotHeader *>(header);
+    directory = reinterpret_cast<SlotEntry *>(header + sizeof(SlotHeader));
+    capacity = slot_header->count;
+    return;
+  }
   capacity = DEFAULT_PAGE_SIZE * 8 / (td.length() * 8 + 1);
   header = page.data();
   data = header + DEFAULT_PAGE_SIZE - td.length() * capacity;
 }
 
-size_t HeapPage::begin() const {
-  for (size_t i = 0; i < capacity; i++) {
-    if (!empty(i)) {
-      return i;
+uint64_t HeapPage::word(size_t i) const {
+  // The last word may extend past the header, those bytes read as empty slots
+  size_t header_bytes = (capacity + 7) / 8;
+  uint64_t bits = 0;
+  std::memcpy(&bits, header + i * 8, std::min<size_t>(8, header_bytes - i * 8));
+  // The first slot of a byte is its most significant bit, so read the bytes big-endian
+  if constexpr (std::endian::native == std::endian::little) {
+    bits = __builtin_bswap64(bits);
+  }
+  return bits;
+}
+
+size_t HeapPage::find(size_t slot, bool occupied) const {
+  if (layout == PageLayout::SLOTTED) {
+    while (slot < capacity && (directory[slot].offset != 0) != occupied) {
+      slot++;
+    }
+    // A scan may be past the directory after its trailing records were deleted
+    return std::min(slot, capacity);
+  }
+  while (slot < capacity) {
+    size_t i = slot / 64;
+    uint64_t bits = occupied ? word(i) : ~word(i);
+    // Ignore the slots of the word before `slot`
+    bits &= ~uint64_t{0} >> (slot % 64);
+    if (bits != 0) {
+      // Padding bits after the last slot are never a match
+      return std::min(i * 64 + std::countl_zero(bits), capacity);
     }
+    slot = (i + 1) * 64;
   }
   return capacity;
 }
 
+size_t HeapPage::begin() const { return find(0, true); }
+
 size_t HeapPage::end() const { return capacity; }
 
+size_t HeapPage::claim() {
+  size_t slot = find(0, false);
+  if (slot == capacity) {
+    return capacity;
+  }
+  header[slot / 8] |= 1 << (7 - slot % 8);
+  return slot;
+}
+
+size_t HeapPage::usedBytes() const {
+  size_t used = 0;
+  for (size_t slot = 0; slot < capacity; slot++) {
+    used += directory[slot].offset != 0 ? directory[slot].length : 0;
+  }
+  return used;
+}
+
+size_t HeapPage::recordStart() const { return slot_header->free_end == 0 ? DEFAULT_PAGE_SIZE : slot_header->free_end; }
+
+void HeapPage::compact() {
+  Page copy;
+  std::memcpy(copy.data(), data, DEFAULT_PAGE_SIZE);
+  size_t start = DEFAULT_PAGE_SIZE;
+  for (size_t slot = 0; slot < capacity; slot++) {
+    if (directory[slot].offset != 0) {
+      start -= directory[slot].length;
+      std::memcpy(data + start, copy.data() + directory[slot].offset, directory[slot].length);
+      directory[slot].offset = static_cast<uint16_t>(start);
+    }
+  }
+  slot_header->free_end = static_cast<uint16_t>(start);
+}
+
+bool HeapPage::place(size_t slot, const uint8_t *row, size_t length) {
+  size_t count = std::max(capacity, slot + 1);
+  size_t directory_end = sizeof(SlotHeader) + count * sizeof(SlotEntry);
+  if (directory_end + usedBytes() + length > DEFAULT_PAGE_SIZE) {
+    return false;
+  }
+  // The space of deleted records is only reclaimed when the free space between the directory and the records is short
+  if (directory_end + length > recordStart()) {
+    compact();
+  }
+  size_t start = recordStart() - length;
+  std::memcpy(data + start, row, length);
+  directory[slot] = {static_cast<uint16_t>(start), static_cast<uint16_t>(length)};
+  capacity = count;
+  slot_header->count = static_cast<uint16_t>(count);
+  slot_header->free_end = static_cast<uint16_t>(start);
+  return true;
+}
+
 bool HeapPage::insertTuple(const Tuple &t) {
-  size_t slot = 0;
-  while (slot < capacity && (header[slot / 8] & (1 << (7 - slot % 8)))) {
-    slot++;
+  if (layout == PageLayout::SLOTTED) {
+    std::vector<uint8_t> row(td.length(t));
+    td.serialize(row.data(), t);
+    return insertRow(row.data());
   }
+  size_t slot = claim();
   if (slot == capacity) {
     return false;
   }
-  header[slot / 8] |= 1 << (7 - slot % 8);
-  uint8_t *slotData = data + slot * td.length();
-  td.serialize(slotData, t);
+  write(slot, t);
+  return true;
+}
+
+bool HeapPage::insertRow(const uint8_t *row) {
+  if (layout == PageLayout::SLOTTED) {
+    // Reuse the first empty entry of the directory, or add one
+    return place(size() == capacity ? capacity : find(0, false), row, td.length(row));
+  }
+  size_t slot = claim();
+  if (slot == capacity) {
+    return false;
+  }
+  write(slot, row);
   return true;
 }
 
+void HeapPage::insertTuple(size_t slot, const Tuple &t) {
+  if (layout == PageLayout::SLOTTED) {
+    if (slot > capacity) {
+      throw std::runtime_error("Out of index");
+    }
+    if (slot < capacity && !empty(slot)) {
+      throw std::runtime_error("Slot occupied");
+    }
+    std::vector<uint8_t> row(td.length(t));
+    td.serialize(row.data(), t);
+    if (!place(slot, row.data(), row.size())) {
+      throw std::runtime_error("Page is full");
+    }
+    return;
+  }
+  if (slot >= capacity) {
+    throw std::runtime_error("Out of index");
+  }
+  if (!empty(slot)) {
+    throw std::runtime_error("Slot occupied");
+  }
+  header[slot / 8] |= 1 << (7 - slot % 8);
+  write(slot, t);
+}
+
 void HeapPage::deleteTuple(size_t slot) {
   if (slot >= capacity) {
     throw std::runtime_error("Out of index");
@@ -42,6 +171,18 @@ void HeapPage::deleteTuple(size_t slot) {
   if (empty(slot)) {
     throw std::runtime_error("Slot not occupied");
   }
+  if (layout == PageLayout::SLOTTED) {
+    directory[slot] = {0, 0};
+    // Trailing empty entries are dropped, the others keep the slots of the following records
+    while (capacity > 0 && directory[capacity - 1].offset == 0) {
+      capacity--;
+    }
+    slot_header->count = static_cast<uint16_t>(capacity);
+    if (capacity == 0) {
+      slot_header->free_end = 0;
+    }
+    return;
+  }
   header[slot / 8] &= ~(1 << (7 - slot % 8));
 }
 
@@ -49,13 +190,103 @@ Tuple HeapPage::getTuple(size_t slot) const {
   if (empty(slot)) {
     throw std::runtime_error("Slot not occupied");
   }
+  if (layout != PageLayout::ROW) {
+    return getView(slot).materialize();
+  }
   uint8_t *slotData = data + slot * td.length();
   return td.deserialize(slotData);
 }
 
-void HeapPage::next(size_t &slot) const {
-  while (++slot < capacity && empty(slot))
-    ;
+Tuple HeapPage::getTuple(size_t slot, const std::vector<size_t> &indices) const {
+  return getView(slot).materialize(indices);
 }
 
-bool HeapPage::empty(size_t slot) const { return !(header[slot / 8] & (1 << (7 - slot % 8))); }
+TupleView HeapPage::getView(size_t slot) const {
+  if (empty(slot)) {
+    throw std::runtime_error("Slot not occupied");
+  }
+  if (layout == PageLayout::PAX) {
+    return {td, data, capacity, slot};
+  }
+  if (layout == PageLayout::SLOTTED) {
+    return {td, data + directory[slot].offset};
+  }
+  return {td, data + slot * td.length()};
+}
+
+const uint8_t *HeapPage::getData() const { return data; }
+
+const uint16_t *HeapPage::getDirectory() const { return reinterpret_cast<const uint16_t *>(directory); }
+
+PageLayout HeapPage::getLayout() const { return layout; }
+
+void HeapPage::write(size_t slot, const Tuple &t) {
+  if (layout == PageLayout::ROW) {
+    td.serialize(data + slot * td.length(), t);
+    return;
+  }
+  // Serialize the row, then scatter its fields to the columns
+  std::vector<uint8_t> row(td.length());
+  td.serialize(row.data(), t);
+  write(slot, row.data());
+}
+
+void HeapPage::write(size_t slot, const uint8_t *row) {
+  if (layout == PageLayout::ROW) {
+    std::memcpy(data + slot * td.length(), row, td.length());
+    return;
+  }
+  // The null bitmaps are the first column
+  std::memcpy(data + slot * td.bitmap_length(), row, td.bitmap_length());
+  for (size_t i = 0; i < td.size(); i++) {
+    size_t width = td.width_of(i);
+    std::memcpy(data + capacity * td.offset_of(i) + slot * width, row + td.offset_of(i), width);
+  }
+}
+
+void HeapPage::next(size_t &slot) const { slot = find(slot + 1, true); }
+
+bool HeapPage::empty(size_t slot) const {
+  if (layout == PageLayout::SLOTTED) {
+    return slot >= capacity || directory[slot].offset == 0;
+  }
+  return !(header[slot / 8] & (1 << (7 - slot % 8)));
+}
+
+size_t HeapPage::size() const {
+  size_t live = 0;
+  if (layout == PageLayout::SLOTTED) {
+    for (size_t slot = 0; slot < capacity; slot++) {
+      live += directory[slot].offset != 0;
+    }
+    return live;
+  }
+  for (size_t i = 0; i * 64 < capacity; i++) {
+    uint64_t bits = word(i);
+    // Mask the padding bits after the last slot
+    if ((i + 1) * 64 > capacity) {
+      bits &= ~(~uint64_t{0} >> (capacity % 64));
+    }
+    live += std::popcount(bits);
+  }
+  return live;
+}
+
+size_t HeapPage::freeSlots() const { return capacity - size(); }
+
+uint8_t HeapPage::freeClass() const {
+  if (layout != PageLayout::SLOTTED) {
+    // Any tuple fits in a free slot, so a page with one is never FULL
+    size_t free = freeSlots();
+    return free == 0 ? FreeSpaceMap::FULL : std::max<uint8_t>(FreeSpaceMap::classify(free, capacity), 1);
+  }
+  size_t used = sizeof(SlotHeader) + capacity * sizeof(SlotEntry) + usedBytes();
+  return FreeSpaceMap::classify(DEFAULT_PAGE_SIZE - used, DEFAULT_PAGE_SIZE - sizeof(SlotHeader));
+}
+
+uint8_t HeapPage::requiredClass(size_t length) {
+  size_t capacity = DEFAULT_PAGE_SIZE - sizeof(SlotHeader);
+  size_t need = std::min(length + sizeof(SlotEntry), capacity);
+  // Rounded up, unlike the class of a page, so that every page of this class has room for the record
+  return static_cast<uint8_t>(std::max<size_t>(1, (need * FreeSpaceMap::EMPTY + capacity - 1) / capacity));
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <db/IoEngine.hpp>
+#include <initializer_list>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <system_error>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#define DB_HAVE_IO_URING 1
+#endif
+
+using namespace db;
+
+namespace {
+std::atomic<IoEngineType> default_type{IoEngineType::POSIX};
+std::atomic<size_t> default_depth{DEFAULT_IO_DEPTH};
+
+bool adjacent(const IoRequest &a, const IoRequest &b) {
+  return a.op == b.op && a.fd == b.fd && a.offset + static_cast<off_t>(a.length) == b.offset;
+}
+
+/**
+ * @brief Reads or writes consecutive buffers at an offset of a file, resuming after partial transfers.
+ * @details A read stops early only at the end of the file. `iov` is consumed.
+ * @throws std::runtime_error if the system call fails, or a write makes no progress.
+ */
+void transfer(IoRequest::Op op, int fd, iovec *iov, int count, off_t offset) {
+  while (count > 0) {
+    ssize_t res = op == IoRequest::Op::READ ? preadv(fd, iov, count, offset) : pwritev(fd, iov, count, offset);
+    if (res == -1 && errno == EINTR) {
+      continue;
+    }
+    if (res == -1 || (res == 0 && op == IoRequest::Op::WRITE)) {
+      throw std::runtime_error(op == IoRequest::Op::READ ? "pread" : "pwrite");
+    }
+    if (res == 0) {
+      return;
+    }
+    offset += res;
+    // Skip the buffers that were transferred, and start the next call in the middle of a partial one
+    auto done = static_cast<size_t>(res);
+    while (count > 0 && done >= iov->iov_len) {
+      done -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<uint8_t *>(iov->iov_base) + done;
+      iov->iov_len -= done;
+    }
+  }
+}
+} // namespace
+
+std::unique_ptr<IoEngine> IoEngine::create(IoEngineType type, size_t queue_depth) {
+  if (type == IoEngineType::IO_URING) {
+    try {
+      return std::make_unique<IoUringEngine>(static_cast<unsigned>(queue_depth));
+    } catch (const std::system_error &) {
+      // Not supported by the kernel (or disabled), the POSIX engine works everywhere
+    }
+  }
+  return std::make_unique<PosixIoEngine>();
+}
+
+void IoEngine::setDefault(IoEngineType type, size_t queue_depth) {
+  default_type.store(type, std::memory_order_relaxed);
+  default_depth.store(queue_depth, std::memory_order_relaxed);
+}
+
+IoEngine &IoEngine::local() {
+  thread_local std::unique_ptr<IoEngine> engine;
+  thread_local IoEngineType requested;
+  thread_local size_t depth;
+  IoEngineType type = default_type.load(std::memory_order_relaxed);
+  size_t queue_depth = default_depth.load(std::memory_order_relaxed);
+  // Remember the requested backend rather than the one created, so a fallback is not retried on every call
+  if (!engine || requested != type || depth != queue_depth) {
+    engine = create(type, queue_depth);
+    requested = type;
+    depth = queue_depth;
+  }
+  return *engine;
+}
+
+void PosixIoEngine::submit(const std::vector<IoRequest> &requests) {
+  std::vector<iovec> iov;
+  for (size_t i = 0; i < requests.size();) {
+    // Merge a run of requests for adjacent ranges of a file, up to the limit of a single call
+    size_t end = i + 1;
+    while (end < requests.size() && end - i < IOV_MAX && adjacent(requests[end - 1], requests[end])) {
+      end++;
+    }
+    const IoRequest &first = requests[i];
+    iov.clear();
+    for (size_t j = i; j < end; j++) {
+      iov.push_back({requests[j].data, requests[j].length});
+    }
+    transfer(first.op, first.fd, iov.data(), static_cast<int>(iov.size()), first.offset);
+    i = end;
+  }
+}
+
+IoEngineType PosixIoEngine::type() const { return IoEngineType::POSIX; }
+
+#ifdef DB_HAVE_IO_URING
+namespace {
+/// Returns whether a ring supports the operations, kernels before 5.6 set up rings without IORING_OP_READ and WRITE
+bool supported(int ring_fd, std::initializer_list<unsigned> ops) {
+  constexpr unsigned max_ops = 256;
+  std::vector<uint8_t> buffer(sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op));
+  auto *probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+  // The probe itself came with 5.6, it fails on older kernels
+  if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, max_ops) < 0) {
+    return false;
+  }
+  return std::all_of(ops.begin(), ops.end(), [&](unsigned op) {
+    return op <= probe->last_op && op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+  });
+}
+} // namespace
+
+IoUringEngine::IoUringEngine(unsigned depth) : depth(depth) {
+  io_uring_params params{};
+  ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+  if (ring_fd < 0) {
+    throw std::system_error(errno, std::system_category(), "io_uring_setup");
+  }
+  if (!supported(ring_fd, {IORING_OP_READ, IORING_OP_WRITE})) {
+    unmap();
+    throw std::system_error(EOPNOTSUPP, std::system_category(), "io_uring read and write");
+  }
+  this->depth = params.sq_entries;
+
+  sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+  }
+  sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  cq_ring = single_mmap ? sq_ring
+                        : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                               IORING_OFF_CQ_RING);
+  sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+    int error = errno;
+    unmap();
+    throw std::system_error(error, std::system_category(), "io_uring mmap");
+  }
+
+  auto *sq = static_cast<uint8_t *>(sq_ring);
+  sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<uint8_t *>(cq_ring);
+  cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes = cq + params.cq_off.cqes;
+}
+
+IoUringEngine::~IoUringEngine() { unmap(); }
+
+void IoUringEngine::unmap() {
+  if (sqes && sqes != MAP_FAILED) {
+    munmap(sqes, sqes_size);
+  }
+  if (cq_ring && cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+    munmap(cq_ring, cq_ring_size);
+  }
+  if (sq_ring && sq_ring != MAP_FAILED) {
+    munmap(sq_ring, sq_ring_size);
+  }
+  if (ring_fd >= 0) {
+    close(ring_fd);
+  }
+  sq_ring = cq_ring = sqes = nullptr;
+  ring_fd = -1;
+}
+
+void IoUringEngine::submit(const std::vector<IoRequest> &requests) {
+  auto *entries = static_cast<io_uring_sqe *>(sqes);
+  auto *completions = static_cast<io_uring_cqe *>(cqes);
+  const char *error = nullptr;
+  // The requests that completed with fewer bytes than requested, and how many bytes they transferred
+  std::vector<std::pair<size_t, size_t>> partial;
+  for (size_t base = 0; base < requests.size(); base += depth) {
+    unsigned count = static_cast<unsigned>(std::min<size_t>(depth, requests.size() - base));
+
+    // The queue is empty between batches, so the entries of this batch are the first `count` slots after the tail
+    unsigned tail = std::atomic_ref(*sq_tail).load(std::memory_order_relaxed);
+    for (unsigned i = 0; i < count; i++) {
+      const IoRequest &request = requests[base + i];
+      unsigned index = (tail + i) & *sq_mask;
+      io_uring_sqe &sqe = entries[index];
+      sqe = {};
+      sqe.opcode = request.op == IoRequest::Op::READ ? IORING_OP_READ : IORING_OP_WRITE;
+      sqe.fd = request.fd;
+      sqe.addr = reinterpret_cast<uint64_t>(request.data);
+      sqe.len = static_cast<uint32_t>(request.length);
+      sqe.off = static_cast<uint64_t>(request.offset);
+      sqe.user_data = base + i;
+      sq_array[index] = index;
+    }
+    std::atomic_ref(*sq_tail).store(tail + count, std::memory_order_release);
+
+    unsigned submitted = 0;
+    unsigned completed = 0;
+    while (completed < count) {
+      unsigned to_submit = count - submitted;
+      int res = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd, to_submit, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (res < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::system_error(errno, std::system_category(), "io_uring_enter");
+      }
+      submitted += static_cast<unsigned>(res);
+      unsigned head = std::atomic_ref(*cq_head).load(std::memory_order_relaxed);
+      unsigned ready = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+      for (; head != ready; head++, completed++) {
+        const io_uring_cqe &cqe = completions[head & *cq_mask];
+        const IoRequest &request = requests[cqe.user_data];
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+          partial.emplace_back(cqe.user_data, 0);
+        } else if (cqe.res < 0 && !error) {
+          error = request.op == IoRequest::Op::READ ? "io_uring read" : "io_uring write";
+        } else if (cqe.res >= 0 && static_cast<size_t>(cqe.res) < request.length &&
+                   (cqe.res > 0 || request.op == IoRequest::Op::WRITE)) {
+          // A read that returns nothing is at the end of the file
+          partial.emplace_back(cqe.user_data, static_cast<size_t>(cqe.res));
+        }
+      }
+      std::atomic_ref(*cq_head).store(head, std::memory_order_release);
+    }
+  }
+  // Report a failure only once every request of the batch completed, the buffers are in use until then
+  if (error) {
+    throw std::runtime_error(error);
+  }
+  // Finish the partial transfers with blocking calls, they are rare
+  for (auto [i, done] : partial) {
+    const IoRequest &request = requests[i];
+    iovec rest{static_cast<uint8_t *>(request.data) + done, request.length - done};
+    transfer(request.op, request.fd, &rest, 1, request.offset + static_cast<off_t>(done));
+  }
+}
+#else
+IoUringEngine::IoUringEngine(unsigned depth) : depth(depth) {
+  throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring");
+}
+
+IoUringEngine::~IoUringEngine() = default;
+
+void IoUringEngine::unmap() {}
+
+void IoUringEngine::submit(const std::vector<IoRequest> &) {
+  throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring");
+}
+#endif
+
+IoEngineType IoUringEngine::type() const { return IoEngineType::IO_URING; }
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <bit>
+#include <db/IoStats.hpp>
+#include <stdexcept>
+
+using namespace db;
+
+size_t LatencyCounts::bucket(std::chrono::nanoseconds latency) {
+  auto us = static_cast<size_t>(std::max<int64_t>(0, latency.count()) / 1000);
+  return std::min<size_t>(std::bit_width(us), NUM_BUCKETS - 1);
+}
+
+void LatencyCounts::record(std::chrono::nanoseconds latency) {
+  buckets[bucket(latency)]++;
+  total += latency;
+}
+
+std::chrono::nanoseconds LatencyCounts::mean() const {
+  size_t n = count();
+  return n == 0 ? std::chrono::nanoseconds(0) : total / static_cast<int64_t>(n);
+}
+
+LatencyCounts &LatencyCounts::operator+=(const LatencyCounts &other) {
+  for (size_t k = 0; k < NUM_BUCKETS; k++) {
+    buckets[k] += other.buckets[k];
+  }
+  total += other.total;
+  return *this;
+}
+
+size_t LatencyCounts::count() const {
+  size_t total = 0;
+  for (size_t n : buckets) {
+    total += n;
+  }
+  return total;
+}
+
+std::chrono::microseconds LatencyCounts::quantile(double q) const {
+  size_t total = count();
+  if (total == 0) {
+    return std::chrono::microseconds(0);
+  }
+  auto rank = static_cast<size_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1));
+  size_t seen = 0;
+  for (size_t k = 0; k < NUM_BUCKETS; k++) {
+    seen += buckets[k];
+    if (seen > rank) {
+      return std::chrono::microseconds(size_t{1} << k);
+    }
+  }
+  return std::chrono::microseconds(size_t{1} << (NUM_BUCKETS - 1));
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  buckets[LatencyCounts::bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+  total_ns.fetch_add(latency.count(), std::memory_order_relaxed);
+}
+
+LatencyCounts LatencyHistogram::snapshot() const {
+  LatencyCounts counts;
+  for (size_t k = 0; k < LatencyCounts::NUM_BUCKETS; k++) {
+    counts.buckets[k] = buckets[k].load(std::memory_order_relaxed);
+  }
+  counts.total = std::chrono::nanoseconds(total_ns.load(std::memory_order_relaxed));
+  return counts;
+}
+
+void IoTrace::reset(size_t capacity) {
+  entries = capacity > 0 ? std::make_unique<std::atomic<size_t>[]>(capacity) : nullptr;
+  this->capacity = capacity;
+  recorded.store(0);
+}
+
+void IoTrace::record(size_t id) {
+  size_t i = recorded.fetch_add(1, std::memory_order_relaxed);
+  if (capacity > 0) {
+    entries[i % capacity].store(id, std::memory_order_relaxed);
+  }
+}
+
+void IoTrace::record(const std::vector<size_t> &ids) {
+  size_t first = recorded.fetch_add(ids.size(), std::memory_order_relaxed);
+  if (capacity > 0) {
+    for (size_t i = 0; i < ids.size(); i++) {
+      entries[(first + i) % capacity].store(ids[i], std::memory_order_relaxed);
+    }
+  }
+}
+
+size_t IoTrace::size() const { return recorded.load(std::memory_order_relaxed); }
+
+size_t IoTrace::operator[](size_t i) const {
+  size_t n = size();
+  if (i >= n || n - i > capacity) {
+    throw std::out_of_range("IoTrace entry is not retained");
+  }
+  return entries[i % capacity].load(std::memory_order_relaxed);
+}
+
+std::vector<size_t> IoTrace::retained() const {
+  size_t n = size();
+  std::vector<size_t> ids;
+  for (size_t i = n - std::min(n, capacity); i < n; i++) {
+    ids.push_back(entries[i % capacity].load(std::memory_order_relaxed));
+  }
+  return ids;
+}
@@ -3,10 +3,23 @@
 
 using namespace db;
 
-Iterator::Iterator(const DbFile &file, const size_t &page, size_t slot) : file(file), page(page), slot(slot) {}
+Iterator::Iterator(const DbFile &file, const size_t &page, size_t slot, PageGuard guard, std::shared_ptr<ScanRing> ring,
+                   std::shared_ptr<ReadAhead> read_ahead)
+    : file(file), page(page), slot(slot), guard(std::move(guard)), ring(std::move(ring)),
+      read_ahead(std::move(read_ahead)) {}
 
 Tuple Iterator::operator*() const { return file.getTuple(*this); }
 
+TupleView Iterator::view() { return file.getTupleView(*this); }
+
+void PageBatch::clear() {
+  page.release();
+  data = nullptr;
+  capacity = 0;
+  directory = nullptr;
+  slots.clear();
+}
+
 Iterator &Iterator::operator++() {
   file.next(*this);
   return *this;
@@ -22,6 +22,13 @@ int LeafPage::split(LeafPage &new_page) {
   return std::get<int>(td.deserialize(new_page.data).get_field(key_index));
 }
 
+TupleView LeafPage::getView(size_t slot) const {
+  if (slot >= header->size) {
+    throw std::out_of_range("slot out of range");
+  }
+  return {td, data + slot * td.length()};
+}
+
 Tuple LeafPage::getTuple(size_t slot) const {
   if (slot >= header->size) {
     throw std::out_of_range("slot out of range");
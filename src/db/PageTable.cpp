@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <bit>
+#include <db/PageTable.hpp>
+#include <stdexcept>
+
+using namespace db;
+
+PageTable::PageTable(size_t capacity)
+    : slots(std::bit_ceil(std::max<size_t>(2, 2 * capacity)), Slot{0, EMPTY, 0}), mask(slots.size() - 1) {
+  if (capacity >= EMPTY) {
+    throw std::length_error("Page table capacity is too large");
+  }
+}
+
+size_t PageTable::probe(const PageId &pid) const {
+  size_t i = home(pid);
+  while (slots[i].pos != EMPTY && (slots[i].page != pid.page || slots[i].file != pid.file)) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+size_t PageTable::find(const PageId &pid) const {
+  const Slot &slot = slots[probe(pid)];
+  return slot.pos == EMPTY ? npos : slot.pos;
+}
+
+size_t PageTable::at(const PageId &pid) const {
+  size_t pos = find(pid);
+  if (pos == npos) {
+    throw std::out_of_range("Page is not in the buffer pool");
+  }
+  return pos;
+}
+
+void PageTable::insert(const PageId &pid, size_t pos) {
+  Slot &slot = slots[probe(pid)];
+  if (slot.pos == EMPTY) {
+    // Keep at least one empty slot, so that every probe sequence ends
+    if (2 * (count + 1) > slots.size()) {
+      throw std::length_error("Page table is full");
+    }
+    count++;
+  }
+  slot = {pid.file, static_cast<uint32_t>(pos), pid.page};
+}
+
+bool PageTable::erase(const PageId &pid) {
+  size_t hole = probe(pid);
+  if (slots[hole].pos == EMPTY) {
+    return false;
+  }
+  count--;
+  // Backward shift: move every following entry of the run whose home is not between the hole and itself into the hole
+  for (size_t i = (hole + 1) & mask; slots[i].pos != EMPTY; i = (i + 1) & mask) {
+    size_t h = home({slots[i].file, slots[i].page});
+    if (((i - h) & mask) >= ((i - hole) & mask)) {
+      slots[hole] = slots[i];
+      hole = i;
+    }
+  }
+  slots[hole].pos = EMPTY;
+  return true;
+}
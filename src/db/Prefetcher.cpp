@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <db/BufferPool.hpp>
+#include <db/DbFile.hpp>
+#include <db/Prefetcher.hpp>
+
+using namespace db;
+
+Prefetcher::Prefetcher(Load load, size_t batch)
+    : load(std::move(load)), batch(std::max<size_t>(1, batch)), worker(&Prefetcher::run, this) {}
+
+Prefetcher::~Prefetcher() {
+  {
+    std::lock_guard lock(latch);
+    stopping = true;
+  }
+  ready.notify_all();
+  worker.join();
+}
+
+void Prefetcher::run() {
+  std::unique_lock lock(latch);
+  while (true) {
+    ready.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (stopping) {
+      return;
+    }
+    std::vector<PrefetchRequest> requests;
+    while (!queue.empty() && requests.size() < batch) {
+      current.push_back(queue.front().file);
+      requests.push_back(std::move(queue.front()));
+      queue.pop_front();
+    }
+    lock.unlock();
+    std::vector<PrefetchRequest> next = load(requests);
+    lock.lock();
+    // Queue the rest of the chains before the files are released, so that cancel drops them
+    for (PrefetchRequest &request : next) {
+      queue.push_back(std::move(request));
+    }
+    current.clear();
+    idle.notify_all();
+  }
+}
+
+void Prefetcher::submit(PrefetchRequest request) {
+  {
+    std::lock_guard lock(latch);
+    queue.push_back(std::move(request));
+  }
+  ready.notify_one();
+}
+
+bool Prefetcher::take(const PageId &pid) {
+  std::lock_guard lock(latch);
+  auto it = std::find_if(queue.begin(), queue.end(), [&](const PrefetchRequest &request) { return request.pid == pid; });
+  if (it == queue.end()) {
+    return false;
+  }
+  if (it->remaining == 0) {
+    queue.erase(it);
+  }
+  return true;
+}
+
+void Prefetcher::cancel(const DbFile &file) {
+  std::unique_lock lock(latch);
+  idle.wait(lock, [&] { return std::find(current.begin(), current.end(), &file) == current.end(); });
+  std::erase_if(queue, [&](const PrefetchRequest &request) { return request.file == &file; });
+}
+
+ReadAhead::ReadAhead(BufferPool &pool, const DbFile &file, size_t window) : pool(pool), file(file), window(window) {}
+
+bool ReadAhead::step(size_t page, size_t next) {
+  bool sequential = page == expected && next != PrefetchRequest::npos;
+  expected = next;
+  ahead = sequential && ahead > 0 ? ahead - 1 : 0;
+  return sequential && ahead <= window / 2;
+}
+
+void ReadAhead::advance(size_t page) {
+  if (!step(page, page + 1)) {
+    return;
+  }
+  // One request per page, so that the scan can take back the pages it reaches before the prefetcher
+  size_t end = std::min(page + 1 + window, file.getNumPages());
+  for (size_t next = page + 1 + ahead; next < end; next++) {
+    pool.prefetch({&file, {file.getId(), next}, 0, {}});
+  }
+  ahead = window;
+}
+
+void ReadAhead::advance(size_t page, size_t next, const std::function<size_t(const Page &)> &successor) {
+  if (!step(page, next)) {
+    return;
+  }
+  // The successors are only known once the pages are loaded, so the chain is followed from the next page again
+  pool.prefetch({&file, {file.getId(), next}, window - 1, successor});
+  ahead = window;
+}
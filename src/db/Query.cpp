@@ -1,204 +1,402 @@
+#include <cstring>
 #include <db/Query.hpp>
+#include <optional>
 #include <stdexcept>  // For std::runtime_error
 #include <limits>     // For std::numeric_limits
 
 
 using namespace db;
 
-void db::projection(const DbFile &in, DbFile &out, const std::vector<std::string> &field_names) {
-  // TODO: Implement this function
-  const TupleDesc &in_td = in.getTupleDesc();
+namespace {
+template <typename T> bool compare(const T &lhs, PredicateOp op, const T &rhs) {
+  switch (op) {
+  case PredicateOp::EQ:
+    return lhs == rhs;
+  case PredicateOp::NE:
+    return lhs != rhs;
+  case PredicateOp::LT:
+    return lhs < rhs;
+  case PredicateOp::LE:
+    return lhs <= rhs;
+  case PredicateOp::GT:
+    return lhs > rhs;
+  case PredicateOp::GE:
+    return lhs >= rhs;
+  }
+  return false;
+}
 
-  // Prepare field types and names for the output table
-  std::vector<type_t> field_types;
-  for (const std::string &field_name : field_names) {
-    size_t index = in_td.index_of(field_name);
-
-    // Infer the type based on offsets
-    size_t offset = in_td.offset_of(index);
-    size_t next_offset = (index + 1 < in_td.size()) ? in_td.offset_of(index + 1) : in_td.length();
-    size_t field_size = next_offset - offset;
-
-    if (field_size == INT_SIZE) {
-      field_types.push_back(type_t::INT);
-    } else if (field_size == DOUBLE_SIZE) {
-      field_types.push_back(type_t::DOUBLE);
-    } else if (field_size <= CHAR_SIZE) {
-      field_types.push_back(type_t::CHAR);
-    } else {
-      throw std::runtime_error("Unsupported field size");
-    }
+/**
+ * @brief Returns the 64-bit integer a value is stored as in a field of one of the 64-bit types.
+ * @details INT values are widened for INT64 fields.
+ * @return The integer, or nullopt if the field is not a 64-bit integer or the value is not of its type.
+ */
+std::optional<int64_t> wide(type_t type, const field_t &value) {
+  if (type == type_t::INT64 && std::holds_alternative<int64_t>(value)) {
+    return std::get<int64_t>(value);
+  }
+  if (type == type_t::INT64 && std::holds_alternative<int>(value)) {
+    return std::get<int>(value);
   }
+  if (type == type_t::TIMESTAMP && std::holds_alternative<timestamp_t>(value)) {
+    return std::get<timestamp_t>(value).micros;
+  }
+  if (type == type_t::DECIMAL && std::holds_alternative<decimal_t>(value)) {
+    return std::get<decimal_t>(value).units;
+  }
+  return std::nullopt;
+}
 
-  TupleDesc out_td(field_types, field_names);
+/// Wraps the 64-bit integer of a field of one of the 64-bit types into a value of its type
+field_t wrap(type_t type, int64_t value) {
+  switch (type) {
+  case type_t::TIMESTAMP:
+    return timestamp_t{value};
+  case type_t::DECIMAL:
+    return decimal_t{value};
+  default:
+    return value;
+  }
+}
+
+/**
+ * @brief Evaluates `field op value` on a field of a tuple view.
+ * @details Fields of the same type as the value are compared in place, so CHAR fields are not copied into strings. A
+ * comparison with NULL is unknown, so it is false.
+ */
+bool matches(const TupleView &view, size_t index, PredicateOp op, const field_t &value) {
+  if (std::holds_alternative<null_t>(value) || view.is_null(index)) {
+    return false;
+  }
+  type_t type = view.field_type(index);
+  if (type == type_t::INT && std::holds_alternative<int>(value)) {
+    return compare(view.get_int(index), op, std::get<int>(value));
+  }
+  if (type == type_t::DOUBLE && std::holds_alternative<double>(value)) {
+    return compare(view.get_double(index), op, std::get<double>(value));
+  }
+  if ((type == type_t::CHAR || type == type_t::VARCHAR) && std::holds_alternative<string_t>(value)) {
+    return compare(view.get_char(index), op, std::get<string_t>(value).view());
+  }
+  if (std::optional<int64_t> rhs = wide(type, value)) {
+    int64_t lhs = type == type_t::INT64       ? view.get_int64(index)
+                  : type == type_t::TIMESTAMP ? view.get_timestamp(index).micros
+                                              : view.get_decimal(index).units;
+    return compare(lhs, op, *rhs);
+  }
+  return compare(view.get_field(index), op, value);
+}
+
+/// Reads the field `c` of the `row`-th tuple of a batch, which must have type T
+template <typename T> T load(const PageBatch &batch, size_t c, size_t row) {
+  T value;
+  std::memcpy(&value, batch.field(c, row), sizeof(T));
+  return value;
+}
 
-  // Iterate over the input table and project selected fields into the output table
-  for (Iterator it = in.begin(); it != in.end(); ++it) {
-    Tuple in_tuple = *it;
-    std::vector<field_t> projected_fields;
-    for (const std::string &field_name : field_names) {
-      size_t index = in_td.index_of(field_name);
-      projected_fields.push_back(in_tuple.get_field(index));
+/**
+ * @brief Keeps the rows of `selected` whose field satisfies `field op value`.
+ * @details INT, DOUBLE and 64-bit integer columns are read directly from the page, a column at a time, which has unit
+ * stride in a PAX page. Other predicates are evaluated on the views of the rows. The rows whose field is NULL are
+ * dropped first, which is skipped for fields that are not nullable.
+ */
+void select(const PageBatch &batch, size_t c, PredicateOp op, const field_t &value, std::vector<size_t> &selected) {
+  if (std::holds_alternative<null_t>(value)) {
+    selected.clear();
+    return;
+  }
+  type_t type = batch.td->type_of(c);
+  size_t kept = 0;
+  if (batch.td->is_nullable(c)) {
+    for (size_t row : selected) {
+      selected[kept] = row;
+      kept += !TupleDesc::is_null(batch.nulls(row), c);
+    }
+    selected.resize(kept);
+    kept = 0;
+  }
+  if (type == type_t::INT && std::holds_alternative<int>(value)) {
+    int rhs = std::get<int>(value);
+    for (size_t row : selected) {
+      selected[kept] = row;
+      kept += compare(load<int>(batch, c, row), op, rhs);
+    }
+  } else if (type == type_t::DOUBLE && std::holds_alternative<double>(value)) {
+    double rhs = std::get<double>(value);
+    for (size_t row : selected) {
+      selected[kept] = row;
+      kept += compare(load<double>(batch, c, row), op, rhs);
+    }
+  } else if (std::optional<int64_t> rhs = wide(type, value)) {
+    for (size_t row : selected) {
+      selected[kept] = row;
+      kept += compare(load<int64_t>(batch, c, row), op, *rhs);
+    }
+  } else {
+    for (size_t row : selected) {
+      selected[kept] = row;
+      kept += matches(batch.view(row), c, op, value);
     }
-    Tuple out_tuple(projected_fields);
-    out.insertTuple(out_tuple);
   }
+  selected.resize(kept);
 }
 
-void db::filter(const DbFile &in, DbFile &out, const std::vector<FilterPredicate> &pred) {
-  // TODO: Implement this function
-  const TupleDesc &td = in.getTupleDesc();
+/**
+ * @brief Inserts the result rows of an operator into a file.
+ * @details Fixed-length rows are copied from the input pages without being deserialized if the file has the field
+ * types and nullability of the result. Otherwise the tuples are deserialized, so that the file rejects them as it would
+ * reject any tuple.
+ */
+class RowWriter {
+  DbFile &out;
+  bool copy;
+  /// Whether the result rows have a null bitmap, which two concatenated rows do not form
+  bool bitmap;
+  std::vector<uint8_t> row;
+
+public:
+  /**
+   * @param out The file to insert into.
+   * @param td The TupleDesc of the result rows.
+   */
+  RowWriter(DbFile &out, const TupleDesc &td) : out(out), bitmap(td.bitmap_length() > 0), row(td.length()) {
+    const TupleDesc &out_td = out.getTupleDesc();
+    copy = td.is_fixed() && out_td.size() == td.size();
+    for (size_t i = 0; copy && i < td.size(); i++) {
+      copy = out_td.type_of(i) == td.type_of(i) && out_td.is_nullable(i) == td.is_nullable(i);
+    }
+  }
 
-  // Iterate through input table tuples
-  for (Iterator it = in.begin(); it != in.end(); ++it) {
-    Tuple tuple = *it;
-    bool satisfies_all = true;
+  void write(const TupleView &view) {
+    if (copy) {
+      view.serialize(row.data());
+      out.insertRow(row.data());
+    } else {
+      out.insertTuple(view.materialize());
+    }
+  }
 
-    // Check if the tuple satisfies all predicates
-    for (const FilterPredicate &predicate : pred) {
-      size_t field_index = td.index_of(predicate.field_name);
-      const field_t &field_value = tuple.get_field(field_index);
+  /// Inserts the listed fields of a tuple
+  void write(const TupleView &view, const std::vector<size_t> &indices) {
+    if (copy) {
+      view.serialize(row.data(), indices);
+      out.insertRow(row.data());
+    } else {
+      out.insertTuple(view.materialize(indices));
+    }
+  }
 
-      bool satisfies = false;
-      switch (predicate.op) {
-      case PredicateOp::EQ:
-        satisfies = (field_value == predicate.value);
-        break;
-      case PredicateOp::NE:
-        satisfies = (field_value != predicate.value);
-        break;
-      case PredicateOp::LT:
-        satisfies = (field_value < predicate.value);
+  /// Inserts the fields of a tuple of `left_length` bytes followed by the fields of another tuple
+  void write(const TupleView &left, const TupleView &right, size_t left_length) {
+    if (copy && !bitmap) {
+      left.serialize(row.data());
+      right.serialize(row.data() + left_length);
+      out.insertRow(row.data());
+      return;
+    }
+    std::vector<field_t> fields;
+    fields.reserve(left.size() + right.size());
+    for (size_t i = 0; i < left.size(); i++) {
+      fields.push_back(left.get_field(i));
+    }
+    for (size_t i = 0; i < right.size(); i++) {
+      fields.push_back(right.get_field(i));
+    }
+    out.insertTuple(Tuple(fields));
+  }
+};
+
+/**
+ * @brief Summarizes a column of integers of type T, which are the values of INT fields or the 64-bit integers of the
+ * other integer types.
+ * @details NULL fields are skipped, as in SQL.
+ * @param count Set to the number of fields that are not NULL.
+ * @return The sum, minimum or maximum of the column, or the sum for AVG.
+ */
+template <typename T> T summarize(const DbFile &in, size_t index, AggregateOp op, size_t &count) {
+  T result = op == AggregateOp::MIN ? std::numeric_limits<T>::max()
+             : op == AggregateOp::MAX ? std::numeric_limits<T>::min()
+                                      : 0;
+  bool nullable = in.getTupleDesc().is_nullable(index);
+  count = 0;
+  // Perform aggregation, a page at a time, reading the field straight from the column of the page
+  PageBatch batch;
+  for (Iterator it = in.begin(); in.nextBatch(it, batch);) {
+    if (!nullable && op == AggregateOp::COUNT) {
+      count += batch.size();
+      continue;
+    }
+    for (size_t row = 0; row < batch.size(); row++) {
+      if (nullable && TupleDesc::is_null(batch.nulls(row), index)) {
+        continue;
+      }
+      count++;
+      if (op == AggregateOp::COUNT) {
+        continue;
+      }
+      T value = load<T>(batch, index, row);
+      switch (op) {
+      case AggregateOp::SUM:
+      case AggregateOp::AVG:
+        result += value;
         break;
-      case PredicateOp::LE:
-        satisfies = (field_value <= predicate.value);
+      case AggregateOp::MIN:
+        result = std::min(result, value);
         break;
-      case PredicateOp::GT:
-        satisfies = (field_value > predicate.value);
+      case AggregateOp::MAX:
+        result = std::max(result, value);
         break;
-      case PredicateOp::GE:
-        satisfies = (field_value >= predicate.value);
+      case AggregateOp::COUNT:
         break;
       }
+    }
+  }
+  return result;
+}
 
-      if (!satisfies) {
-        satisfies_all = false;
-        break;
-      }
+/// The operation with its operands swapped: `a op b` is `b flip(op) a`
+PredicateOp flip(PredicateOp op) {
+  switch (op) {
+  case PredicateOp::LT:
+    return PredicateOp::GT;
+  case PredicateOp::LE:
+    return PredicateOp::GE;
+  case PredicateOp::GT:
+    return PredicateOp::LT;
+  case PredicateOp::GE:
+    return PredicateOp::LE;
+  default:
+    return op;
+  }
+}
+} // namespace
+
+void db::projection(const DbFile &in, DbFile &out, const std::vector<std::string> &field_names) {
+  const TupleDesc &in_td = in.getTupleDesc();
+
+  // Prepare field types, names and nullability for the output table
+  std::vector<type_t> field_types;
+  std::vector<bool> nullable;
+  for (const std::string &field_name : field_names) {
+    field_types.push_back(in_td.type_of(in_td.index_of(field_name)));
+    nullable.push_back(in_td.is_nullable(in_td.index_of(field_name)));
+  }
+
+  TupleDesc out_td(field_types, field_names, nullable);
+
+  std::vector<size_t> indices;
+  for (const std::string &field_name : field_names) {
+    indices.push_back(in_td.index_of(field_name));
+  }
+
+  // Iterate over the input table a page at a time and copy the selected fields into the output table, without
+  // decoding them
+  RowWriter writer(out, out_td);
+  PageBatch batch;
+  for (Iterator it = in.begin(); in.nextBatch(it, batch);) {
+    for (size_t row = 0; row < batch.size(); row++) {
+      writer.write(batch.view(row), indices);
+    }
+  }
+}
+
+void db::filter(const DbFile &in, DbFile &out, const std::vector<FilterPredicate> &pred) {
+  const TupleDesc &td = in.getTupleDesc();
+
+  std::vector<size_t> field_indices;
+  for (const FilterPredicate &predicate : pred) {
+    field_indices.push_back(td.index_of(predicate.field_name));
+  }
+
+  // Iterate through input table tuples a page at a time and narrow the rows of each page down a predicate at a time,
+  // the rows that pass are copied without being deserialized
+  RowWriter writer(out, td);
+  PageBatch batch;
+  std::vector<size_t> selected;
+  for (Iterator it = in.begin(); in.nextBatch(it, batch);) {
+    selected.resize(batch.size());
+    for (size_t row = 0; row < batch.size(); row++) {
+      selected[row] = row;
+    }
+    for (size_t i = 0; i < pred.size() && !selected.empty(); i++) {
+      select(batch, field_indices[i], pred[i].op, pred[i].value, selected);
     }
 
-    // If all predicates are satisfied, insert the tuple into the output table
-    if (satisfies_all) {
-      out.insertTuple(tuple);
+    // Insert the tuples that satisfy all predicates into the output table
+    for (size_t row : selected) {
+      writer.write(batch.view(row));
     }
   }
 }
 
 void db::aggregate(const DbFile &in, DbFile &out, const Aggregate &agg) {
-  // TODO: Implement this function
   const TupleDesc &in_td = in.getTupleDesc();
   size_t field_index = in_td.index_of(agg.field);
 
+  type_t type = in_td.type_of(field_index);
   field_t result;
   size_t count = 0;
 
-  // Initialize result based on the aggregate operation
-  if (agg.op == AggregateOp::SUM || agg.op == AggregateOp::AVG) {
-    result = 0;
-  } else if (agg.op == AggregateOp::MIN) {
-    result = std::numeric_limits<int>::max();
-  } else if (agg.op == AggregateOp::MAX) {
-    result = std::numeric_limits<int>::min();
-  }
-
-  // Perform aggregation
-  for (Iterator it = in.begin(); it != in.end(); ++it) {
-    Tuple tuple = *it;
-    const field_t &value = tuple.get_field(field_index);
-
-    switch (agg.op) {
-    case AggregateOp::SUM:
-    case AggregateOp::AVG:
-        result = std::get<int>(result) + std::get<int>(value);
-      break;
-    case AggregateOp::MIN:
-      result = std::min(std::get<int>(result), std::get<int>(value));
-      break;
-    case AggregateOp::MAX:
-      result = std::max(std::get<int>(result), std::get<int>(value));
-      break;
-    case AggregateOp::COUNT:
-      result = std::get<int>(result) + 1;
-      break;
+  if (agg.op == AggregateOp::COUNT) {
+    summarize<int>(in, field_index, agg.op, count);
+    result = static_cast<int>(count);
+  } else if (type == type_t::INT) {
+    int sum = summarize<int>(in, field_index, agg.op, count);
+    result = sum;
+    // Handle AVG separately
+    if (agg.op == AggregateOp::AVG) {
+      result = static_cast<double>(sum) / count;
     }
-    count++;
+  } else if (type == type_t::INT64 || type == type_t::TIMESTAMP || type == type_t::DECIMAL) {
+    if (type == type_t::TIMESTAMP && agg.op == AggregateOp::SUM) {
+      throw std::logic_error("TIMESTAMP fields cannot be summed");
+    }
+    int64_t sum = summarize<int64_t>(in, field_index, agg.op, count);
+    result = wrap(type, sum);
+    // The average of a DECIMAL is its value, the average of a TIMESTAMP is in microseconds since the epoch
+    if (agg.op == AggregateOp::AVG) {
+      double scale = type == type_t::DECIMAL ? DECIMAL_SCALE : 1;
+      result = static_cast<double>(sum) / scale / count;
+    }
+  } else {
+    throw std::logic_error("Aggregated field is not an integer or DECIMAL");
   }
 
-  // Handle AVG separately
-  if (agg.op == AggregateOp::AVG && count > 0) {
-    result = static_cast<double>(std::get<int>(result)) / count;
+  // Only COUNT has a value on no values
+  if (agg.op != AggregateOp::COUNT && count == 0) {
+    result = null_t{};
   }
 
   // Create output tuple and insert it into the output table
   std::vector<field_t> result_fields = {result};
   Tuple result_tuple(result_fields);
   out.insertTuple(result_tuple);
-
 }
 
 void db::join(const DbFile &left, const DbFile &right, DbFile &out, const JoinPredicate &pred) {
-  // TODO: Implement this function
   const TupleDesc &left_td = left.getTupleDesc();
-    const TupleDesc &right_td = right.getTupleDesc();
-    TupleDesc out_td = TupleDesc::merge(left_td, right_td);
-
-    size_t left_field_index = left_td.index_of(pred.left);
-    size_t right_field_index = right_td.index_of(pred.right);
-
-    // Perform nested-loop join
-    for (Iterator left_it = left.begin(); left_it != left.end(); ++left_it) {
-        Tuple left_tuple = *left_it;
-        const field_t &left_value = left_tuple.get_field(left_field_index);
-
-        for (Iterator right_it = right.begin(); right_it != right.end(); ++right_it) {
-            Tuple right_tuple = *right_it;
-            const field_t &right_value = right_tuple.get_field(right_field_index);
-
-            bool matches = false;
-            switch (pred.op) {
-            case PredicateOp::EQ:
-                matches = (left_value == right_value);
-                break;
-            case PredicateOp::NE:
-                matches = (left_value != right_value);
-                break;
-            case PredicateOp::LT:
-                matches = (left_value < right_value);
-                break;
-            case PredicateOp::LE:
-                matches = (left_value <= right_value);
-                break;
-            case PredicateOp::GT:
-                matches = (left_value > right_value);
-                break;
-            case PredicateOp::GE:
-                matches = (left_value >= right_value);
-                break;
-            }
-
-            if (matches) {
-                // Merge tuples
-                std::vector<field_t> merged_fields(left_tuple.size() + right_tuple.size());
-                for (size_t i = 0; i < left_tuple.size(); ++i) {
-                    merged_fields[i] = left_tuple.get_field(i);
-                }
-                for (size_t i = 0; i < right_tuple.size(); ++i) {
-                    merged_fields[left_tuple.size() + i] = right_tuple.get_field(i);
-                }
-
-                Tuple out_tuple(merged_fields);
-                out.insertTuple(out_tuple);
-            }
+  const TupleDesc &right_td = right.getTupleDesc();
+  TupleDesc out_td = TupleDesc::merge(left_td, right_td);
+
+  size_t left_field_index = left_td.index_of(pred.left);
+  size_t right_field_index = right_td.index_of(pred.right);
+
+  // Perform nested-loop join, the merged rows are the left row followed by the right row
+  RowWriter writer(out, out_td);
+  PageBatch right_batch;
+  for (Iterator left_it = left.begin(); left_it != left.end(); ++left_it) {
+    TupleView left_view = left_it.view();
+    const field_t left_value = left_view.get_field(left_field_index);
+
+    // The inner table is scanned a page at a time, and its matching rows are copied without being deserialized
+    for (Iterator right_it = right.begin(); right.nextBatch(right_it, right_batch);) {
+      for (size_t row = 0; row < right_batch.size(); row++) {
+        TupleView right_view = right_batch.view(row);
+        if (!matches(right_view, right_field_index, flip(pred.op), left_value)) {
+          continue;
         }
+        writer.write(left_view, right_view, left_td.length());
+      }
     }
+  }
 }
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <bit>
+#include <db/ReplacementPolicy.hpp>
+#include <stdexcept>
+
+using namespace db;
+
+std::unique_ptr<ReplacementPolicy> ReplacementPolicy::create(ReplacementPolicyType type, size_t num_frames) {
+  switch (type) {
+  case ReplacementPolicyType::LRU:
+    return std::make_unique<LruPolicy>(num_frames);
+  case ReplacementPolicyType::CLOCK:
+    return std::make_unique<ClockPolicy>(num_frames);
+  case ReplacementPolicyType::TWO_Q:
+    return std::make_unique<TwoQueuePolicy>(num_frames);
+  }
+  throw std::invalid_argument("Unknown replacement policy");
+}
+
+LruPolicy::LruPolicy(size_t num_frames) : prev(num_frames, npos), next(num_frames, npos) {}
+
+void LruPolicy::pushFront(size_t pos) {
+  prev[pos] = npos;
+  next[pos] = head;
+  if (head != npos) {
+    prev[head] = pos;
+  } else {
+    tail = pos;
+  }
+  head = pos;
+}
+
+void LruPolicy::pushBack(size_t pos) {
+  next[pos] = npos;
+  prev[pos] = tail;
+  if (tail != npos) {
+    next[tail] = pos;
+  } else {
+    head = pos;
+  }
+  tail = pos;
+}
+
+void LruPolicy::unlink(size_t pos) {
+  if (prev[pos] != npos) {
+    next[prev[pos]] = next[pos];
+  } else {
+    head = next[pos];
+  }
+  if (next[pos] != npos) {
+    prev[next[pos]] = prev[pos];
+  } else {
+    tail = prev[pos];
+  }
+  prev[pos] = next[pos] = npos;
+}
+
+void LruPolicy::insert(size_t pos, size_t) { pushFront(pos); }
+
+void LruPolicy::touch(size_t pos) {
+  if (head != pos) {
+    unlink(pos);
+    pushFront(pos);
+  }
+}
+
+void LruPolicy::erase(size_t pos) { unlink(pos); }
+
+void LruPolicy::demote(size_t pos) {
+  unlink(pos);
+  pushBack(pos);
+}
+
+size_t LruPolicy::victim(const std::function<bool(size_t)> &evictable) {
+  size_t pos = tail;
+  while (pos != npos && !evictable(pos)) {
+    pos = prev[pos];
+  }
+  return pos;
+}
+
+void LruPolicy::coldest(size_t n, std::vector<size_t> &out) const {
+  out.clear();
+  for (size_t pos = tail; pos != npos && out.size() < n; pos = prev[pos]) {
+    out.push_back(pos);
+  }
+}
+
+ClockPolicy::ClockPolicy(size_t num_frames) : referenced(num_frames), tracked(num_frames) {}
+
+void ClockPolicy::insert(size_t pos, size_t) {
+  tracked[pos] = 1;
+  referenced[pos] = 1;
+}
+
+void ClockPolicy::touch(size_t pos) { referenced[pos] = 1; }
+
+void ClockPolicy::erase(size_t pos) {
+  tracked[pos] = 0;
+  referenced[pos] = 0;
+}
+
+void ClockPolicy::demote(size_t pos) { referenced[pos] = 0; }
+
+size_t ClockPolicy::victim(const std::function<bool(size_t)> &evictable) {
+  // Two full sweeps are enough: the first clears every reference bit that is set
+  size_t n = referenced.size();
+  for (size_t step = 0; step < 2 * n; step++) {
+    size_t pos = hand;
+    hand = (hand + 1) % n;
+    if (!tracked[pos] || !evictable(pos)) {
+      continue;
+    }
+    if (referenced[pos]) {
+      referenced[pos] = 0;
+      continue;
+    }
+    return pos;
+  }
+  return npos;
+}
+
+void ClockPolicy::coldest(size_t n, std::vector<size_t> &out) const {
+  // In hand order, the frames the hand would take on its first sweep come before the ones with a second chance
+  out.clear();
+  size_t size = referenced.size();
+  for (uint8_t bit : {0, 1}) {
+    for (size_t step = 0; step < size && out.size() < n; step++) {
+      size_t pos = (hand + step) % size;
+      if (tracked[pos] && referenced[pos] == bit) {
+        out.push_back(pos);
+      }
+    }
+  }
+}
+
+TwoQueuePolicy::TwoQueuePolicy(size_t num_frames)
+    : prev(num_frames, npos), next(num_frames, npos), queue(num_frames, Queue::NONE), keys(num_frames),
+      kin(std::max<size_t>(1, num_frames / 4)), kout(std::max<size_t>(1, num_frames / 2)), a1out(2 * kout),
+      a1out_keys(std::bit_ceil(2 * kout), Ghost{0, npos}), a1out_mask(a1out_keys.size() - 1) {}
+
+TwoQueuePolicy::List &TwoQueuePolicy::listOf(Queue q) { return q == Queue::A1IN ? a1in : am; }
+
+void TwoQueuePolicy::pushFront(Queue q, size_t pos) {
+  List &list = listOf(q);
+  queue[pos] = q;
+  prev[pos] = npos;
+  next[pos] = list.head;
+  if (list.head != npos) {
+    prev[list.head] = pos;
+  } else {
+    list.tail = pos;
+  }
+  list.head = pos;
+  list.size++;
+}
+
+void TwoQueuePolicy::pushBack(Queue q, size_t pos) {
+  List &list = listOf(q);
+  queue[pos] = q;
+  next[pos] = npos;
+  prev[pos] = list.tail;
+  if (list.tail != npos) {
+    next[list.tail] = pos;
+  } else {
+    list.head = pos;
+  }
+  list.tail = pos;
+  list.size++;
+}
+
+void TwoQueuePolicy::unlink(size_t pos) {
+  List &list = listOf(queue[pos]);
+  if (prev[pos] != npos) {
+    next[prev[pos]] = next[pos];
+  } else {
+    list.head = next[pos];
+  }
+  if (next[pos] != npos) {
+    prev[next[pos]] = prev[pos];
+  } else {
+    list.tail = prev[pos];
+  }
+  prev[pos] = next[pos] = npos;
+  queue[pos] = Queue::NONE;
+  list.size--;
+}
+
+void TwoQueuePolicy::remember(size_t key) {
+  if (a1out_tail - a1out_head == a1out.size()) {
+    compact();
+  }
+  // A key that is remembered again becomes the newest, its older entry turns stale
+  size_t slot = ghostSlot(key);
+  if (a1out_keys[slot].ticket == npos) {
+    a1out_size++;
+  }
+  a1out_keys[slot] = {key, a1out_tail};
+  a1out[a1out_tail++ % a1out.size()] = key;
+  while (a1out_size > kout) {
+    size_t ticket = a1out_head++;
+    size_t oldest = ghostSlot(a1out[ticket % a1out.size()]);
+    if (a1out_keys[oldest].ticket == ticket) {
+      forget(oldest);
+    }
+  }
+}
+
+size_t TwoQueuePolicy::ghostSlot(size_t key) const {
+  // Keys are hashes already
+  size_t i = key & a1out_mask;
+  while (a1out_keys[i].ticket != npos && a1out_keys[i].key != key) {
+    i = (i + 1) & a1out_mask;
+  }
+  return i;
+}
+
+void TwoQueuePolicy::forget(size_t slot) {
+  a1out_size--;
+  // Backward shift, like PageTable::erase
+  size_t hole = slot;
+  for (size_t i = (hole + 1) & a1out_mask; a1out_keys[i].ticket != npos; i = (i + 1) & a1out_mask) {
+    size_t home = a1out_keys[i].key & a1out_mask;
+    if (((i - home) & a1out_mask) >= ((i - hole) & a1out_mask)) {
+      a1out_keys[hole] = a1out_keys[i];
+      hole = i;
+    }
+  }
+  a1out_keys[hole].ticket = npos;
+}
+
+void TwoQueuePolicy::compact() {
+  // The ring holds at most kout live entries, so a full ring frees at least half of it
+  size_t out = a1out_head;
+  for (size_t ticket = a1out_head; ticket != a1out_tail; ticket++) {
+    size_t key = a1out[ticket % a1out.size()];
+    Ghost &ghost = a1out_keys[ghostSlot(key)];
+    if (ghost.ticket == ticket) {
+      ghost.ticket = out;
+      a1out[out++ % a1out.size()] = key;
+    }
+  }
+  a1out_tail = out;
+}
+
+size_t TwoQueuePolicy::victimIn(const List &list, const std::function<bool(size_t)> &evictable) const {
+  size_t pos = list.tail;
+  while (pos != npos && !evictable(pos)) {
+    pos = prev[pos];
+  }
+  return pos;
+}
+
+void TwoQueuePolicy::coldestIn(const List &list, size_t n, std::vector<size_t> &out) const {
+  for (size_t pos = list.tail; pos != npos && out.size() < n; pos = prev[pos]) {
+    out.push_back(pos);
+  }
+}
+
+void TwoQueuePolicy::insert(size_t pos, size_t key) {
+  keys[pos] = key;
+  if (size_t slot = ghostSlot(key); a1out_keys[slot].ticket != npos) {
+    // Referenced again soon after leaving A1in: the page is hot
+    forget(slot);
+    pushFront(Queue::AM, pos);
+  } else {
+    pushFront(Queue::A1IN, pos);
+  }
+}
+
+void TwoQueuePolicy::touch(size_t pos) {
+  if (am.head != pos) {
+    unlink(pos);
+    pushFront(Queue::AM, pos);
+  }
+}
+
+void TwoQueuePolicy::erase(size_t pos) {
+  if (queue[pos] != Queue::NONE) {
+    unlink(pos);
+  }
+}
+
+void TwoQueuePolicy::demote(size_t pos) {
+  unlink(pos);
+  pushBack(Queue::A1IN, pos);
+}
+
+size_t TwoQueuePolicy::victim(const std::function<bool(size_t)> &evictable) {
+  size_t pos = npos;
+  if (a1in.size > kin || am.size == 0) {
+    pos = victimIn(a1in, evictable);
+  }
+  if (pos == npos) {
+    pos = victimIn(am, evictable);
+  }
+  if (pos == npos) {
+    pos = victimIn(a1in, evictable);
+  }
+  if (pos != npos && queue[pos] == Queue::A1IN) {
+    remember(keys[pos]);
+  }
+  return pos;
+}
+
+void TwoQueuePolicy::coldest(size_t n, std::vector<size_t> &out) const {
+  out.clear();
+  if (a1in.size > kin || am.size == 0) {
+    coldestIn(a1in, n, out);
+    coldestIn(am, n, out);
+  } else {
+    coldestIn(am, n, out);
+    coldestIn(a1in, n, out);
+  }
+}
@@ -1,11 +1,55 @@
+#include <algorithm>
 #include <cstring>
 #include <db/Tuple.hpp>
 #include <stdexcept>
 
 using namespace db;
 
+namespace {
+/// Reads the value of a VARCHAR field of a serialized row, `field` is the offset of the value in the fixed part
+std::string_view varchar(const uint8_t *row, const uint8_t *field) {
+  uint16_t offset;
+  uint16_t length;
+  std::memcpy(&offset, field, VARCHAR_SIZE);
+  std::memcpy(&length, row + offset, sizeof(length));
+  return {reinterpret_cast<const char *>(row + offset + sizeof(length)), length};
+}
+
+/// Reads a field of one of the 64-bit integer types
+field_t wide(type_t type, const uint8_t *field) {
+  int64_t value;
+  std::memcpy(&value, field, INT64_SIZE);
+  switch (type) {
+  case type_t::TIMESTAMP:
+    return timestamp_t{value};
+  case type_t::DECIMAL:
+    return decimal_t{value};
+  default:
+    return value;
+  }
+}
+
+/// Sets the bit of a NULL field in a null bitmap
+void set_null(uint8_t *bitmap, size_t index) { bitmap[index / 8] |= 1 << (7 - index % 8); }
+
+/// Writes the value of a VARCHAR field at `row + tail` and its offset at `field`, returns the end of the value
+size_t put_varchar(uint8_t *row, uint8_t *field, size_t tail, std::string_view value) {
+  if (tail + sizeof(uint16_t) + value.size() > UINT16_MAX) {
+    throw std::length_error("Tuple is too long");
+  }
+  auto offset = static_cast<uint16_t>(tail);
+  auto length = static_cast<uint16_t>(value.size());
+  std::memcpy(field, &offset, VARCHAR_SIZE);
+  std::memcpy(row + tail, &length, sizeof(length));
+  std::memcpy(row + tail + sizeof(length), value.data(), value.size());
+  return tail + sizeof(length) + value.size();
+}
+} // namespace
+
 Tuple::Tuple(const std::vector<field_t> &fields) : fields(fields) {}
 
+Tuple::Tuple(std::vector<field_t> &&fields) : fields(std::move(fields)) {}
+
 type_t Tuple::field_type(size_t i) const {
   const field_t &field = fields.at(i);
   if (std::holds_alternative<int>(field)) {
@@ -14,21 +58,45 @@ type_t Tuple::field_type(size_t i) const {
   if (std::holds_alternative<double>(field)) {
     return type_t::DOUBLE;
   }
-  if (std::holds_alternative<std::string>(field)) {
+  if (std::holds_alternative<string_t>(field)) {
     return type_t::CHAR;
   }
+  if (std::holds_alternative<int64_t>(field)) {
+    return type_t::INT64;
+  }
+  if (std::holds_alternative<timestamp_t>(field)) {
+    return type_t::TIMESTAMP;
+  }
+  if (std::holds_alternative<decimal_t>(field)) {
+    return type_t::DECIMAL;
+  }
+  if (std::holds_alternative<null_t>(field)) {
+    throw std::logic_error("Field is NULL");
+  }
   throw std::logic_error("Unknown field type");
 }
 
+bool Tuple::is_null(size_t i) const { return std::holds_alternative<null_t>(fields.at(i)); }
+
 size_t Tuple::size() const { return fields.size(); }
 
 const field_t &Tuple::get_field(size_t i) const { return fields.at(i); }
 
-TupleDesc::TupleDesc(const std::vector<type_t> &types, const std::vector<std::string> &names) : types(types) {
+TupleDesc::TupleDesc(const std::vector<type_t> &types, const std::vector<std::string> &names,
+                     const std::vector<bool> &nullable)
+    : types(types), nullable(nullable) {
   if (types.size() != names.size()) {
     throw std::logic_error("Types and names sizes do not match");
   }
-  size_t offset = 0;
+  if (nullable.empty()) {
+    this->nullable.assign(types.size(), false);
+  } else if (nullable.size() != types.size()) {
+    throw std::logic_error("Types and nullable sizes do not match");
+  }
+  for (bool n : this->nullable) {
+    bitmap = n ? (types.size() + 7) / 8 : bitmap;
+  }
+  size_t offset = bitmap;
   for (size_t i = 0; i < types.size(); i++) {
     offsets.push_back(offset);
     name_to_index[names[i]] = i;
@@ -42,6 +110,15 @@ TupleDesc::TupleDesc(const std::vector<type_t> &types, const std::vector<std::st
     case type_t::CHAR:
       offset += CHAR_SIZE;
       break;
+    case type_t::VARCHAR:
+      offset += VARCHAR_SIZE;
+      fixed = false;
+      break;
+    case type_t::INT64:
+    case type_t::TIMESTAMP:
+    case type_t::DECIMAL:
+      offset += INT64_SIZE;
+      break;
     }
   }
   if (name_to_index.size() != names.size()) {
@@ -55,7 +132,15 @@ bool TupleDesc::compatible(const Tuple &tuple) const {
   }
 
   for (size_t i = 0; i < tuple.size(); i++) {
-    if (tuple.field_type(i) != types[i]) {
+    if (tuple.is_null(i)) {
+      if (!nullable[i]) {
+        return false;
+      }
+      continue;
+    }
+    // A VARCHAR field holds a string, like a CHAR field
+    type_t type = types[i] == type_t::VARCHAR ? type_t::CHAR : types[i];
+    if (tuple.field_type(i) != type) {
       return false;
     }
   }
@@ -65,10 +150,38 @@ bool TupleDesc::compatible(const Tuple &tuple) const {
 
 size_t TupleDesc::offset_of(const size_t &index) const { return offsets.at(index); }
 
+type_t TupleDesc::type_of(size_t index) const { return types.at(index); }
+
+bool TupleDesc::is_nullable(size_t index) const { return nullable.at(index); }
+
+size_t TupleDesc::bitmap_length() const { return bitmap; }
+
+bool TupleDesc::is_null(const uint8_t *bitmap, size_t index) {
+  return bitmap[index / 8] & (1 << (7 - index % 8));
+}
+
+size_t TupleDesc::width_of(size_t index) const {
+  switch (types.at(index)) {
+  case type_t::INT:
+    return INT_SIZE;
+  case type_t::DOUBLE:
+    return DOUBLE_SIZE;
+  case type_t::CHAR:
+    return CHAR_SIZE;
+  case type_t::VARCHAR:
+    return VARCHAR_SIZE;
+  case type_t::INT64:
+  case type_t::TIMESTAMP:
+  case type_t::DECIMAL:
+    return INT64_SIZE;
+  }
+  throw std::logic_error("Unknown field type");
+}
+
 size_t TupleDesc::index_of(const std::string &name) const { return name_to_index.at(name); }
 
 size_t TupleDesc::length() const {
-  size_t length = 0;
+  size_t length = bitmap;
   for (type_t type : types) {
     switch (type) {
     case type_t::INT:
@@ -80,17 +193,55 @@ size_t TupleDesc::length() const {
     case type_t::CHAR:
       length += CHAR_SIZE;
       break;
+    case type_t::VARCHAR:
+      length += VARCHAR_SIZE;
+      break;
+    case type_t::INT64:
+    case type_t::TIMESTAMP:
+    case type_t::DECIMAL:
+      length += INT64_SIZE;
+      break;
     }
   }
   return length;
 }
 
+size_t TupleDesc::length(const Tuple &t) const {
+  size_t n = length();
+  for (size_t i = 0; i < types.size(); i++) {
+    if (types[i] == type_t::VARCHAR) {
+      n += sizeof(uint16_t) + (t.is_null(i) ? 0 : std::get<string_t>(t.get_field(i)).size());
+    }
+  }
+  return n;
+}
+
+size_t TupleDesc::length(const uint8_t *data) const {
+  size_t n = length();
+  for (size_t i = 0; i < types.size(); i++) {
+    if (types[i] == type_t::VARCHAR) {
+      n += sizeof(uint16_t) + varchar(data, data + offsets[i]).size();
+    }
+  }
+  return n;
+}
+
+bool TupleDesc::is_fixed() const { return fixed; }
+
 size_t TupleDesc::size() const { return types.size(); }
 
 Tuple TupleDesc::deserialize(const uint8_t *data) const {
   std::vector<field_t> fields;
   fields.reserve(types.size());
-  for (const type_t &type : types) {
+  const uint8_t *row = data;
+  data += bitmap;
+  for (size_t i = 0; i < types.size(); i++) {
+    const type_t &type = types[i];
+    if (nullable[i] && is_null(row, i)) {
+      fields.emplace_back(null_t{});
+      data += width_of(i);
+      continue;
+    }
     switch (type) {
     case type_t::INT:
       fields.emplace_back(*reinterpret_cast<const int *>(data));
@@ -100,19 +251,80 @@ Tuple TupleDesc::deserialize(const uint8_t *data) const {
       fields.emplace_back(*reinterpret_cast<const double *>(data));
       data += DOUBLE_SIZE;
       break;
-    case type_t::CHAR:
-      fields.emplace_back(std::string(reinterpret_cast<const char *>(data)));
+    case type_t::CHAR: {
+      // A string of CHAR_SIZE characters fills the field without a terminator
+      auto chars = reinterpret_cast<const char *>(data);
+      fields.emplace_back(string_t(chars, strnlen(chars, CHAR_SIZE)));
       data += CHAR_SIZE;
       break;
     }
+    case type_t::VARCHAR:
+      fields.emplace_back(string_t(varchar(row, data)));
+      data += VARCHAR_SIZE;
+      break;
+    case type_t::INT64:
+    case type_t::TIMESTAMP:
+    case type_t::DECIMAL:
+      fields.push_back(wide(type, data));
+      data += INT64_SIZE;
+      break;
+    }
+  }
+  return {std::move(fields)};
+}
+
+Tuple TupleDesc::deserialize(const uint8_t *data, const std::vector<size_t> &indices) const {
+  std::vector<field_t> fields;
+  fields.reserve(indices.size());
+  for (size_t index : indices) {
+    const uint8_t *field = data + offsets.at(index);
+    if (nullable[index] && is_null(data, index)) {
+      fields.emplace_back(null_t{});
+      continue;
+    }
+    switch (types[index]) {
+    case type_t::INT:
+      fields.emplace_back(*reinterpret_cast<const int *>(field));
+      break;
+    case type_t::DOUBLE:
+      fields.emplace_back(*reinterpret_cast<const double *>(field));
+      break;
+    case type_t::CHAR: {
+      auto chars = reinterpret_cast<const char *>(field);
+      fields.emplace_back(string_t(chars, strnlen(chars, CHAR_SIZE)));
+      break;
+    }
+    case type_t::VARCHAR:
+      fields.emplace_back(string_t(varchar(data, field)));
+      break;
+    case type_t::INT64:
+    case type_t::TIMESTAMP:
+    case type_t::DECIMAL:
+      fields.push_back(wide(types[index], field));
+      break;
+    }
   }
-  return {fields};
+  return {std::move(fields)};
 }
 
 void TupleDesc::serialize(uint8_t *data, const Tuple &t) const {
+  uint8_t *row = data;
+  size_t tail = length();
+  std::memset(data, 0, bitmap);
+  data += bitmap;
   for (size_t i = 0; i < types.size(); i++) {
     const type_t &type = types[i];
     const field_t &field = t.get_field(i);
+    if (t.is_null(i)) {
+      set_null(row, i);
+      if (type == type_t::VARCHAR) {
+        tail = put_varchar(row, data, tail, "");
+      } else {
+        std::memset(data, 0, width_of(i));
+      }
+      data += width_of(i);
+      continue;
+    }
     switch (type) {
     case type_t::INT:
       *reinterpret_cast<int *>(data) = std::get<int>(field);
@@ -122,11 +334,32 @@ void TupleDesc::serialize(uint8_t *data, const Tuple &t) const {
       *reinterpret_cast<double *>(data) = std::get<double>(field);
       data += DOUBLE_SIZE;
       break;
-    case type_t::CHAR:
-      strncpy(reinterpret_cast<char *>(data), std::get<std::string>(field).c_str(), CHAR_SIZE);
+    case type_t::CHAR: {
+      // Longer values are cut at CHAR_SIZE characters, shorter ones are padded with NULs
+      const string_t &value = std::get<string_t>(field);
+      size_t size = std::min(value.size(), CHAR_SIZE);
+      std::memcpy(data, value.data(), size);
+      std::memset(data + size, 0, CHAR_SIZE - size);
       data += CHAR_SIZE;
       break;
     }
+    case type_t::VARCHAR:
+      tail = put_varchar(row, data, tail, std::get<string_t>(field));
+      data += VARCHAR_SIZE;
+      break;
+    case type_t::INT64:
+      std::memcpy(data, &std::get<int64_t>(field), INT64_SIZE);
+      data += INT64_SIZE;
+      break;
+    case type_t::TIMESTAMP:
+      std::memcpy(data, &std::get<timestamp_t>(field).micros, TIMESTAMP_SIZE);
+      data += TIMESTAMP_SIZE;
+      break;
+    case type_t::DECIMAL:
+      std::memcpy(data, &std::get<decimal_t>(field).units, DECIMAL_SIZE);
+      data += DECIMAL_SIZE;
+      break;
+    }
   }
 }
 
@@ -140,5 +373,171 @@ db::TupleDesc TupleDesc::merge(const TupleDesc &td1, const TupleDesc &td2) {
   for (const auto &[name, index] : td2.name_to_index) {
     names[td1.size() + index] = name;
   }
-  return {types, names};
+  std::vector<bool> nullable(td1.nullable);
+  nullable.insert(nullable.end(), td2.nullable.begin(), td2.nullable.end());
+  return {types, names, nullable};
+}
+
+TupleView::TupleView(const TupleDesc &td, const uint8_t *data) : td(&td), data(data) {}
+
+TupleView::TupleView(const TupleDesc &td, const uint8_t *columns, size_t capacity, size_t slot)
+    : td(&td), data(columns), capacity(capacity), slot(slot) {}
+
+const uint8_t *TupleView::field(size_t i) const {
+  if (capacity == 0) {
+    return data + td->offset_of(i);
+  }
+  return data + capacity * td->offset_of(i) + slot * td->width_of(i);
+}
+
+size_t TupleView::size() const { return td->size(); }
+
+type_t TupleView::field_type(size_t i) const { return td->type_of(i); }
+
+bool TupleView::is_null(size_t i) const {
+  if (!td->is_nullable(i)) {
+    return false;
+  }
+  // The bitmap is the first column of a PAX page
+  return TupleDesc::is_null(data + slot * td->bitmap_length(), i);
+}
+
+int TupleView::get_int(size_t i) const {
+  if (td->type_of(i) != type_t::INT) {
+    throw std::logic_error("Field is not an INT");
+  }
+  int value;
+  std::memcpy(&value, field(i), INT_SIZE);
+  return value;
+}
+
+double TupleView::get_double(size_t i) const {
+  if (td->type_of(i) != type_t::DOUBLE) {
+    throw std::logic_error("Field is not a DOUBLE");
+  }
+  double value;
+  std::memcpy(&value, field(i), DOUBLE_SIZE);
+  return value;
+}
+
+std::string_view TupleView::get_char(size_t i) const {
+  if (td->type_of(i) == type_t::VARCHAR) {
+    // Rows with VARCHAR fields are never stored in PAX pages
+    return varchar(data, field(i));
+  }
+  if (td->type_of(i) != type_t::CHAR) {
+    throw std::logic_error("Field is not a CHAR");
+  }
+  // A string of CHAR_SIZE characters fills the field without a terminator
+  auto chars = reinterpret_cast<const char *>(field(i));
+  return {chars, strnlen(chars, CHAR_SIZE)};
+}
+
+int64_t TupleView::get_int64(size_t i) const {
+  if (td->type_of(i) != type_t::INT64) {
+    throw std::logic_error("Field is not an INT64");
+  }
+  int64_t value;
+  std::memcpy(&value, field(i), INT64_SIZE);
+  return value;
+}
+
+timestamp_t TupleView::get_timestamp(size_t i) const {
+  if (td->type_of(i) != type_t::TIMESTAMP) {
+    throw std::logic_error("Field is not a TIMESTAMP");
+  }
+  timestamp_t value;
+  std::memcpy(&value.micros, field(i), TIMESTAMP_SIZE);
+  return value;
+}
+
+decimal_t TupleView::get_decimal(size_t i) const {
+  if (td->type_of(i) != type_t::DECIMAL) {
+    throw std::logic_error("Field is not a DECIMAL");
+  }
+  decimal_t value;
+  std::memcpy(&value.units, field(i), DECIMAL_SIZE);
+  return value;
+}
+
+field_t TupleView::get_field(size_t i) const {
+  if (is_null(i)) {
+    return null_t{};
+  }
+  switch (td->type_of(i)) {
+  case type_t::INT:
+    return get_int(i);
+  case type_t::DOUBLE:
+    return get_double(i);
+  case type_t::CHAR:
+  case type_t::VARCHAR:
+    return string_t(get_char(i));
+  case type_t::INT64:
+    return get_int64(i);
+  case type_t::TIMESTAMP:
+    return get_timestamp(i);
+  case type_t::DECIMAL:
+    return get_decimal(i);
+  }
+  throw std::logic_error("Unknown field type");
+}
+
+Tuple TupleView::materialize() const {
+  if (capacity == 0) {
+    return td->deserialize(data);
+  }
+  std::vector<field_t> fields;
+  fields.reserve(size());
+  for (size_t i = 0; i < size(); i++) {
+    fields.push_back(get_field(i));
+  }
+  return {std::move(fields)};
+}
+
+Tuple TupleView::materialize(const std::vector<size_t> &indices) const {
+  if (capacity == 0) {
+    return td->deserialize(data, indices);
+  }
+  std::vector<field_t> fields;
+  fields.reserve(indices.size());
+  for (size_t index : indices) {
+    fields.push_back(get_field(index));
+  }
+  return {std::move(fields)};
+}
+
+void TupleView::serialize(uint8_t *out) const {
+  if (capacity == 0) {
+    std::memcpy(out, data, td->length(data));
+    return;
+  }
+  std::memcpy(out, data + slot * td->bitmap_length(), td->bitmap_length());
+  for (size_t i = 0; i < size(); i++) {
+    std::memcpy(out + td->offset_of(i), field(i), td->width_of(i));
+  }
+}
+
+void TupleView::serialize(uint8_t *out, const std::vector<size_t> &indices) const {
+  // The projected row has its own null bitmap, and the values of VARCHAR fields follow its fixed part
+  size_t bitmap = 0;
+  size_t tail = 0;
+  for (size_t index : indices) {
+    bitmap = td->is_nullable(index) ? (indices.size() + 7) / 8 : bitmap;
+    tail += td->width_of(index);
+  }
+  tail += bitmap;
+  std::memset(out, 0, bitmap);
+  uint8_t *fixed = out + bitmap;
+  for (size_t j = 0; j < indices.size(); j++) {
+    size_t index = indices[j];
+    if (is_null(index)) {
+      set_null(out, j);
+    }
+    if (td->type_of(index) == type_t::VARCHAR) {
+      tail = put_varchar(out, fixed, tail, get_char(index));
+    } else {
+      std::memcpy(fixed, field(index), td->width_of(index));
+    }
+    fixed += td->width_of(index);
+  }
 }
@@ -14,6 +14,8 @@ public:
    * @brief Initialize a BTreeFile
    *
    * @param key_index the index of the key in the tuple
+   * @throws std::logic_error if the tuples have VARCHAR fields
+   * @throws std::logic_error if the key is nullable
    */
   BTreeFile(const std::string &name, const TupleDesc &td, size_t key_index);
 
@@ -37,6 +39,8 @@ public:
    */
   Tuple getTuple(const Iterator &it) const override;
 
+  TupleView getTupleView(Iterator &it) const override;
+
   /**
    * @brief Advance the iterator to the next tuple.
    * @details Advance the iterator to the next tuple by moving to the next slot of the page.
@@ -45,6 +49,8 @@ public:
    */
   void next(Iterator &it) const override;
 
+  bool nextBatch(Iterator &it, PageBatch &batch, size_t max_rows = SIZE_MAX) const override;
+
   /**
    * @brief Get the iterator to the first tuple of the leftmost leaf (head).
    * @details Traverse the tree to reach the head leaf and return the first tuple.
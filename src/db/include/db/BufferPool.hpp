@@ -1,37 +1,273 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <db/IoEngine.hpp>
+#include <db/IoStats.hpp>
+#include <db/PageTable.hpp>
+#include <db/Prefetcher.hpp>
+#include <db/ReplacementPolicy.hpp>
 #include <db/types.hpp>
-#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 namespace db {
 constexpr size_t DEFAULT_NUM_PAGES = 50;
+constexpr size_t DEFAULT_SCAN_RING_PAGES = 8;
+constexpr std::chrono::milliseconds DEFAULT_WRITER_INTERVAL{50};
+constexpr size_t DEFAULT_WRITER_MAX_PAGES = 64;
+
+class PageGuard;
+class ScanRing;
+
+/**
+ * @brief Runtime configuration of a BufferPool.
+ * @details The capacity can be given in pages directly or derived from a memory budget with `fromBytes`.
+ */
+struct BufferPoolConfig {
+  /// Number of page frames in the pool
+  size_t num_pages = DEFAULT_NUM_PAGES;
+
+  /// Back the frames with huge pages (explicit if available, transparent otherwise)
+  bool huge_pages = false;
+
+  /// Number of independently latched partitions; a page belongs to shard `BufferPool::shardIndex(pid, num_shards)`
+  size_t num_shards = 1;
+
+  /// The replacement algorithm used by every shard
+  ReplacementPolicyType policy = ReplacementPolicyType::LRU;
+
+  /// Number of frames a sequential scan may cycle through (split across shards); 0 lets scans use the whole pool
+  size_t scan_ring_pages = DEFAULT_SCAN_RING_PAGES;
+
+  /// Number of pages a sequential scan requests ahead of its position, read by a background thread; 0 disables it
+  size_t read_ahead_pages = 0;
+
+  /// Fraction of the frames at the cold end of each shard's replacement order that a background writer keeps clean;
+  /// 0 disables the writer
+  double writer_clean_fraction = 0;
+
+  /// Time between two rounds of the background writer
+  std::chrono::milliseconds writer_interval = DEFAULT_WRITER_INTERVAL;
+
+  /// Number of pages the background writer writes at most per round, which bounds its rate
+  size_t writer_max_pages = DEFAULT_WRITER_MAX_PAGES;
+
+  /// The backend of the page reads and writes of every file while the pool is in use
+  IoEngineType io_engine = IoEngineType::POSIX;
+
+  /// Requests in flight per I/O batch, which is also the largest batch of pages the prefetcher loads at once
+  size_t io_depth = DEFAULT_IO_DEPTH;
+
+  /// Number of dirty pages at the cold end of a shard that are written in one batch when a dirty page is evicted
+  size_t eviction_write_batch = 1;
+
+  /// Read and write the files of the Database with O_DIRECT, so their pages are not cached by the OS as well;
+  /// files on filesystems that reject it keep using the page cache
+  bool direct_io = false;
+
+  /**
+   * @brief Build a configuration that uses at most the specified amount of memory for frames.
+   * @param bytes The memory budget of the pool.
+   * @return A configuration with `bytes / DEFAULT_PAGE_SIZE` frames.
+   * @throws std::invalid_argument if the budget is smaller than one page.
+   */
+  static BufferPoolConfig fromBytes(size_t bytes);
+};
+
+/**
+ * @brief Counters of the background writer of a BufferPool.
+ */
+struct WriterStats {
+  /// Pages written by the background writer
+  size_t pages = 0;
+
+  /// I/O batches used to write them, one per file and round
+  size_t writes = 0;
+
+  /// Pages written per second since the writer started
+  double pages_per_second = 0;
+};
+
+/**
+ * @brief Cache counters of a BufferPool, for all files or for the pages of one file.
+ */
+struct BufferPoolCounters {
+  /// Fetches that found the page resident
+  size_t hits = 0;
+
+  /// Fetches that read the page from disk or waited for a background load of it
+  size_t misses = 0;
+
+  /// Pages evicted to make room for other pages
+  size_t evictions = 0;
+
+  /// Evicted pages that had to be written back first
+  size_t dirty_evictions = 0;
+
+  /// Dirty pages written back by flushPage and flushFile
+  size_t flushes = 0;
+
+  /// Time the misses spent in getPage and fetchPage, including the wait for the latch after the read
+  LatencyCounts miss_latency;
+
+  /// Fraction of the fetches that were hits, or 0 if there were none
+  double hitRatio() const;
+
+  BufferPoolCounters &operator+=(const BufferPoolCounters &other);
+};
+
+/**
+ * @brief A snapshot of the cache counters of a BufferPool.
+ */
+struct BufferPoolStats {
+  /// The counters summed over all files
+  BufferPoolCounters total;
+
+  /// The counters of every file that was accessed, by file name
+  std::unordered_map<std::string, BufferPoolCounters> files;
+};
+
 /**
  * @brief Represents a buffer pool for database pages.
  * @details The BufferPool class is responsible for managing the database pages in memory.
  * It provides functions to get a page, mark a page as dirty, and check the status of pages.
  * The class also supports flushing pages to disk and discarding pages from the buffer pool.
- * @note A BufferPool owns the Page objects that are stored in it.
+ * The frames are partitioned into shards by page id. Each shard has its own latch, page table, free list and
+ * replacement policy, so callers on different threads only contend when their pages map to the same shard.
+ * @note A BufferPool owns the Page objects that are stored in it. The frames live in one contiguous, page-aligned
+ * allocation. The bookkeeping of each frame is kept in an array of frame descriptors, and the page table of a shard is
+ * an open-addressing hash table, so a hit costs no allocation and touches few cache lines.
+ * @note The pool is thread-safe. A Page reference returned by getPage is only valid until the frame is evicted;
+ * use fetchPage to pin the frame for as long as the returned PageGuard is alive.
  */
 class BufferPool {
-  std::array<Page, DEFAULT_NUM_PAGES> pages;
-  std::array<PageId, DEFAULT_NUM_PAGES> pos_to_pid;
-  std::unordered_map<const PageId, size_t> pid_to_pos;
-  std::unordered_set<size_t> dirty;
-  std::vector<size_t> available;
-  std::list<size_t> lru_list;
-  std::unordered_map<size_t, std::list<size_t>::iterator> pos_to_lru;
+  /**
+   * @brief The bookkeeping of a frame, in one 32-byte descriptor so that a hit touches a single cache line of them.
+   */
+  struct alignas(32) Frame {
+    PageId pid;
+    /// Incremented under the latch of the shard but may be decremented without it
+    std::atomic<uint32_t> pins = 0;
+    bool dirty = false;
+    /// Loaded by the prefetcher and not used by any fetch yet
+    bool prefetched = false;
+    /// The scan that owns the frame, if any
+    const ScanRing *ring_owner = nullptr;
+  };
+
+  /**
+   * @brief A partition of the pool. Positions are local to the shard: frame `pos` is `pages[pos]`, described by
+   * `frames[pos]`.
+   * @details A resident frame is either tracked by the replacement policy or owned by a ScanRing, never both. A frame
+   * that the prefetcher is loading is in neither and only appears in `loading`. A page that the background writer is
+   * writing back appears in `writing` until the write completes, even if its frame was evicted in the meantime.
+   * Fetches that would read a page in `loading` or `writing` from disk wait on `io_done` instead.
+   * @note Every member other than `pages` is guarded by `latch`, except for the pin counts of the frames.
+   */
+  struct alignas(64) Shard {
+    mutable std::mutex latch;
+    const size_t index;
+    Page *pages;
+    const size_t num_frames;
+    std::unique_ptr<Frame[]> frames;
+    PageTable pid_to_pos;
+    std::vector<size_t> available;
+    std::unique_ptr<ReplacementPolicy> policy;
+    Prefetcher *prefetcher = nullptr;
+    std::unordered_map<const PageId, size_t> loading;
+    std::unordered_map<const PageId, size_t> writing;
+    std::condition_variable io_done;
+    PrefetchStats prefetch_stats;
+    /// Cache counters indexed by file id, grown as files are accessed
+    std::vector<BufferPoolCounters> stats;
+    const size_t eviction_write_batch;
+
+    Shard(size_t index, Page *pages, size_t num_pages, const BufferPoolConfig &config);
+
+    size_t fetch(std::unique_lock<std::mutex> &lock, const PageId &pid, ScanRing *ring = nullptr);
+
+    void adopt(size_t pos, ScanRing &ring);
+
+    size_t allocate();
+
+    size_t reuseRingFrame(ScanRing &ring);
+
+    bool evictable(size_t pos) const;
+
+    void evict(size_t pos);
+
+    void discardPage(const PageId &pid);
+
+    /// Returns whether the page was dirty and written
+    bool flushPage(const PageId &pid);
+
+    BufferPoolCounters &statsOf(file_id_t file);
+
+    /// Writes the pages of dirty frames, in one batch per file, and marks them clean
+    void writeFrames(std::vector<size_t> &positions);
+  };
+
+  BufferPoolConfig config;
+  Page *pages;
+  size_t pages_bytes;
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::unique_ptr<Prefetcher> prefetcher;
+
+  std::mutex writer_latch;
+  std::condition_variable writer_wakeup;
+  bool writer_stopping = false;
+  std::chrono::steady_clock::time_point writer_started;
+  std::atomic<size_t> written_pages{0};
+  std::atomic<size_t> write_calls{0};
+  std::thread writer;
+
+  Shard &shardOf(const PageId &pid) const;
+
+  /// Sums the cache counters of every shard, and resets them if `reset` is set
+  BufferPoolStats collectStats(bool reset);
+
+  /**
+   * @brief The load function of the prefetcher.
+   * @details Reserves a frame for every requested page that is not resident, reads the reserved frames without holding
+   * the latches in one batch per file, and then makes the pages resident.
+   * @return The requests for the pages that follow the loaded ones in their chains.
+   */
+  std::vector<PrefetchRequest> loadAhead(const std::vector<PrefetchRequest> &requests);
+
+  /**
+   * @brief The background writer: writes back the dirty pages at the cold end of every shard each interval.
+   */
+  void runWriter();
+
+  /**
+   * @brief Writes back the unpinned dirty pages among the coldest frames of a shard.
+   * @details The pages are copied and marked clean under the latch and written without it, sorted by file and page so
+   * that adjacent pages of a file are written by a single call.
+   * @return The number of pages written, at most `budget`.
+   */
+  size_t writeBack(Shard &shard, size_t budget);
+
+  friend class PageGuard;
+  friend class ScanRing;
 
 public:
   /**
-   * @brief: Constructs a BufferPool object with the default number of pages.
+   * @brief: Constructs a BufferPool object with the specified configuration.
+   * @param config: The capacity and memory options of the pool.
+   * @throws std::invalid_argument if the pool has no frames, no shards, or more shards than frames.
+   * @throws std::bad_alloc if the frames cannot be allocated.
    */
-  explicit BufferPool();
+  explicit BufferPool(const BufferPoolConfig &config = {});
 
   /**
    * @brief: Destructs a BufferPool object after flushing all dirty pages to disk.
+   * @note All PageGuards must be released before the pool is destroyed.
    */
   ~BufferPool();
 
@@ -43,14 +279,119 @@ public:
 
   BufferPool &operator=(BufferPool &&) = delete;
 
+  /**
+   * @brief: Returns the configuration the pool was created with.
+   */
+  const BufferPoolConfig &getConfig() const;
+
+  /**
+   * @brief: Returns the number of frames in the pool.
+   */
+  size_t getNumPages() const;
+
+  /**
+   * @brief: Returns the number of shards the frames are partitioned into.
+   */
+  size_t getNumShards() const;
+
+  /**
+   * @brief: Returns the shard of a page in a pool with the specified number of shards.
+   * @details: Taken from the high 32 bits of the page hash. The page table of a shard picks the home slot from the low
+   * bits, so the pages of one shard still spread over all of its slots.
+   */
+  static size_t shardIndex(const PageId &pid, size_t num_shards);
+
   /**
    * @brief: Returns the page with the specified page id.
    * @param pid: The page id of the page to return.
    * @return: The page with the specified page id.
-   * @note This method should make this page the most recently used page.
+   * @note This method reports the access to the replacement policy (with LRU it becomes the most recently used page).
    */
   Page &getPage(const PageId &pid);
 
+  /**
+   * @brief: Returns a pinned handle to the page with the specified page id.
+   * @details The frame cannot be evicted or discarded while the returned guard (or a copy of it) is alive.
+   * @param pid: The page id of the page to return.
+   * @param dirty: Whether to also mark the page as dirty.
+   * @return: A guard that unpins the page when it is destroyed or released.
+   * @throws std::runtime_error if the page is not resident and every frame of its shard is pinned.
+   * @note This method reports the access to the replacement policy (with LRU it becomes the most recently used page).
+   */
+  PageGuard fetchPage(const PageId &pid, bool dirty = false);
+
+  /**
+   * @brief: Returns a pinned handle to a page read by a sequential scan.
+   * @details On a miss the page is loaded into one of the frames of the ring, recycling the ring's oldest unpinned
+   * frame once the ring is full, so the scan does not evict other pages. Hits do not count as accesses for the
+   * replacement policy.
+   * @param pid: The page id of the page to return.
+   * @param ring: The access strategy of the scan, created by makeScanRing. If nullptr, this behaves like fetchPage(pid).
+   * @return: A guard that unpins the page when it is destroyed or released.
+   * @throws std::runtime_error if the page is not resident and every frame of its shard is pinned.
+   */
+  PageGuard fetchPage(const PageId &pid, ScanRing *ring);
+
+  /**
+   * @brief: Returns a pinned handle to a page only if it is resident, without reading it from disk.
+   * @details Waits for a write-back of the page that is in flight, so that a page that is not resident is up to date
+   * on disk. The access is not reported to the replacement policy.
+   * @param pid: The page id of the page to return.
+   * @return: A guard that unpins the page when it is destroyed or released, or an empty guard.
+   */
+  PageGuard fetchResident(const PageId &pid);
+
+  /**
+   * @brief: Creates the buffer access strategy for a new sequential scan.
+   * @return: A ring of `BufferPoolConfig::scan_ring_pages` frames, or nullptr if scan rings are disabled.
+   * @note The ring must be destroyed before the pool.
+   */
+  std::shared_ptr<ScanRing> makeScanRing();
+
+  /**
+   * @brief: Creates the sequential access detection for a new scan of a file.
+   * @return: A detector with a window of `BufferPoolConfig::read_ahead_pages`, or nullptr if read-ahead is disabled.
+   * @note The detector must be destroyed before the pool.
+   */
+  std::shared_ptr<ReadAhead> makeReadAhead(const DbFile &file);
+
+  /**
+   * @brief: Requests pages to be loaded in the background.
+   * @details The prefetched pages are inserted like pages fetched by getPage. A fetch of a page that is being loaded
+   * waits for the load instead of reading the page again.
+   * @param request: The first page to load and the pages to follow it. Ignored if read-ahead is disabled.
+   */
+  void prefetch(PrefetchRequest request);
+
+  /**
+   * @brief: Drops the pending background loads of a file.
+   * @note Must be called before the file is destroyed.
+   */
+  void cancelPrefetch(const DbFile &file);
+
+  /**
+   * @brief: Returns the read-ahead counters summed over all shards.
+   */
+  PrefetchStats getPrefetchStats() const;
+
+  /**
+   * @brief: Returns the counters of the background writer.
+   */
+  WriterStats getWriterStats() const;
+
+  /**
+   * @brief: Returns the cache counters accumulated since the pool was created or the counters were last reset.
+   * @details The counters of every shard are read under its latch, so each shard contributes a consistent snapshot.
+   */
+  BufferPoolStats getStats();
+
+  /**
+   * @brief: Returns the cache counters like getStats and resets them to zero.
+   * @details A fetch is counted either in the returned snapshot or in the next one, never in both or neither, so
+   * periodic calls yield the activity of each period.
+   */
+  BufferPoolStats resetStats();
+
   /**
    * @brief: Marks the page with the specified page id as dirty.
    * @param pid: The page id of the page to mark as dirty.
@@ -76,6 +417,7 @@ public:
    * @param pid: The page id of the page to discard.
    * @note This method does NOT flush the page to disk.
    * @note This method also updates the LRU and dirty pages to exclude tracking this page.
+   * @throws std::logic_error if the page is pinned.
    */
   void discardPage(const PageId &pid);
 
@@ -91,5 +433,102 @@ public:
    * @note This method should call BufferPool::flushPage(pid).
    */
   void flushFile(const std::string &file);
+
+  /**
+   * @brief: Discards all pages of the specified file from the buffer pool.
+   * @param file: The name of the associated file.
+   * @note This method does NOT flush the pages to disk.
+   * @throws std::logic_error if a page of the file is pinned.
+   */
+  void discardFile(const std::string &file);
+};
+
+/**
+ * @brief A buffer access strategy for sequential scans.
+ * @details A ScanRing owns a small set of frames per shard that the scan recycles, so a scan of a large file leaves
+ * the rest of the pool untouched. A frame leaves the ring when its page is requested outside of the scan, and the
+ * remaining frames are handed back to the replacement policy as its next eviction candidates when the ring is
+ * destroyed.
+ */
+class ScanRing {
+  BufferPool &pool;
+  size_t frames_per_shard;
+  std::vector<std::vector<size_t>> frames;
+  std::vector<size_t> cursor;
+
+  friend class BufferPool;
+
+public:
+  ScanRing(BufferPool &pool, size_t frames_per_shard);
+
+  ~ScanRing();
+
+  ScanRing(const ScanRing &) = delete;
+
+  ScanRing &operator=(const ScanRing &) = delete;
+};
+
+/**
+ * @brief A pinned page of a BufferPool.
+ * @details A PageGuard keeps its frame resident until it is destroyed or released. Copies share the page and hold their
+ * own pin. An empty (default constructed or released) guard does not refer to any page. A guard of a memory-mapped
+ * file may instead refer to a read-only page of the mapping, which stays valid while the file is mapped.
+ */
+class PageGuard {
+  BufferPool::Shard *shard = nullptr;
+  size_t pos = 0;
+  Page *page = nullptr;
+  PageId pid{};
+
+  PageGuard(BufferPool::Shard *shard, size_t pos, const PageId &pid);
+
+  /// A page of a read-only file mapping, which needs no pin
+  PageGuard(const Page *page, const PageId &pid);
+
+  friend class BufferPool;
+  friend class DbFile;
+
+public:
+  PageGuard() = default;
+
+  PageGuard(const PageGuard &other);
+
+  PageGuard(PageGuard &&other) noexcept;
+
+  PageGuard &operator=(const PageGuard &other);
+
+  PageGuard &operator=(PageGuard &&other) noexcept;
+
+  /**
+   * @brief Unpins the page.
+   */
+  ~PageGuard();
+
+  explicit operator bool() const { return page != nullptr; }
+
+  Page &operator*() const { return *page; }
+
+  Page *operator->() const { return page; }
+
+  /**
+   * @brief Returns whether the page is read from a file mapping rather than pinned in the pool.
+   */
+  bool isMapped() const { return page != nullptr && shard == nullptr; }
+
+  /**
+   * @brief Returns the page id of the pinned page.
+   */
+  const PageId &getPageId() const { return pid; }
+
+  /**
+   * @brief Marks the pinned page as dirty.
+   * @throws std::logic_error if the page is mapped.
+   */
+  void markDirty();
+
+  /**
+   * @brief Unpins the page and empties the guard.
+   */
+  void release();
 };
 } // namespace db
@@ -3,6 +3,7 @@
 #include <db/BufferPool.hpp>
 #include <db/DbFile.hpp>
 #include <memory>
+#include <shared_mutex>
 
 /**
  * @brief A database is a collection of files and a BufferPool.
@@ -13,11 +14,22 @@
  */
 namespace db {
 class Database {
+  /// Guards the catalog, which the background threads of the BufferPool look up
+  mutable std::shared_mutex latch;
   std::unordered_map<std::string, std::unique_ptr<DbFile>> files;
 
-  BufferPool bufferPool;
+  /// The ids assigned to file names; an id is never reused for another name
+  std::unordered_map<std::string, file_id_t> ids;
 
-  Database() = default;
+  /// The registered file of every id, or nullptr
+  std::vector<DbFile *> by_id;
+
+  /// The name of every id
+  std::vector<std::string> names;
+
+  std::unique_ptr<BufferPool> bufferPool;
+
+  Database();
 
 public:
   friend Database &getDatabase();
@@ -33,11 +45,20 @@ public:
    */
   BufferPool &getBufferPool();
 
+  /**
+   * @brief Replaces the BufferPool with a new one using the specified configuration.
+   * @details The current pool is destroyed, which writes all of its dirty pages back to their files. The direct I/O
+   * mode of the configuration is then applied to every file.
+   * @param config The capacity and memory options of the new pool.
+   * @note References to pages of the previous pool are invalidated.
+   */
+  void configureBufferPool(const BufferPoolConfig &config);
+
   /**
    * @brief Adds a new file to the Database.
    * @param file The file to add.
    * @throws std::logic_error if the file name already exists.
-   * @note This method takes ownership of the DbFile.
+   * @note This method takes ownership of the DbFile and enables direct I/O on it if the BufferPool uses it.
    */
   void add(std::unique_ptr<DbFile> file);
 
@@ -46,7 +67,9 @@ public:
    * @param name The name of the file to remove.
    * @return The removed file.
    * @throws std::logic_error if the name does not exist.
+   * @throws std::logic_error if a page of the file is pinned.
    * @note This method should call BufferPool::flushFile(name)
+   * @note The pages of the file are discarded from the buffer pool.
    * @note This method moves the DbFile ownership to the caller.
    */
   std::unique_ptr<DbFile> remove(const std::string &name);
@@ -58,6 +81,30 @@ public:
    * @throws std::logic_error if the name does not exist.
    */
   DbFile &get(const std::string &name) const;
+
+  /**
+   * @brief Returns the DbFile with the specified file id.
+   * @param id The id of the file name.
+   * @return The DbFile object.
+   * @throws std::out_of_range if no file with that name is registered.
+   */
+  DbFile &get(file_id_t id) const;
+
+  /**
+   * @brief Returns the id of a file name, assigning the next free id to a name that has none yet.
+   * @details Ids are assigned to names rather than files, so a file that is removed and added again keeps its id.
+   * @param name The name of the file.
+   * @return The id used in the PageIds of the file.
+   */
+  file_id_t getFileId(const std::string &name);
+
+  /**
+   * @brief Returns the file name an id was assigned to.
+   * @param id The id of the file name.
+   * @return The name, whether or not a file with that name is registered.
+   * @throws std::out_of_range if the id was never assigned.
+   */
+  std::string getFileName(file_id_t id) const;
 };
 
 /**
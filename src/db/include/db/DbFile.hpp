@@ -1,10 +1,29 @@
 #pragma once
 
+#include <atomic>
+#include <db/IoStats.hpp>
 #include <db/Iterator.hpp>
 #include <db/types.hpp>
+#include <sys/types.h>
 #include <vector>
 
 namespace db {
+struct IoRequest;
+
+/// Direct I/O requires buffers, offsets and lengths aligned to the logical block size of the device
+constexpr size_t DIRECT_IO_ALIGNMENT = DEFAULT_PAGE_SIZE;
+
+/**
+ * @brief The expected access pattern of a memory-mapped file, passed to the kernel with madvise.
+ */
+enum class AccessPattern { NORMAL, SEQUENTIAL, RANDOM };
+
+/**
+ * @brief A page buffer that can be used for direct I/O.
+ */
+struct alignas(DIRECT_IO_ALIGNMENT) AlignedPage {
+  Page page{};
+};
 
 /**
  * @brief Represents a database file.
@@ -13,16 +32,47 @@ namespace db {
  * @note A `DbFile` object owns the `TupleDesc` object that describes the schema of the tuples in the file.
  */
 class DbFile {
-  mutable std::vector<size_t> reads;
-  mutable std::vector<size_t> writes;
+  mutable std::atomic<size_t> pages_read = 0;
+  mutable std::atomic<size_t> pages_written = 0;
+  mutable LatencyHistogram read_latency;
+  mutable LatencyHistogram write_latency;
+  mutable IoTrace reads;
+  mutable IoTrace writes;
 
   int fd;
 
+  /// Set while the file descriptor may have O_DIRECT set, so that unaligned buffers are bounced
+  std::atomic<bool> direct = false;
+
+  /// The read-only mapping of the first `mapped_pages` pages, or nullptr
+  const Page *mapping = nullptr;
+  size_t mapped_pages = 0;
+
+  static off_t offset(size_t id) { return static_cast<off_t>(id * DEFAULT_PAGE_SIZE); }
+
+  void submit(std::vector<IoRequest> &requests) const;
+
+  void read(std::vector<IoRequest> &requests, const std::vector<size_t> &ids) const;
+
+  void write(std::vector<IoRequest> &requests, const std::vector<size_t> &ids) const;
+
 protected:
   const std::string name;
   const TupleDesc td;
   size_t numPages;
 
+  /// The id of `name` in the catalog, used in the PageIds of the file
+  const file_id_t id;
+
+  /**
+   * @brief Returns a handle to a page that is only read.
+   * @details If the page is in the BufferPool it is pinned there, since its frame may be newer than the file. Otherwise,
+   * a page of the mapping is returned without copying it, or the page is fetched through the pool if it is not mapped.
+   * @param page The page number.
+   * @param ring The scan ring used if the page is fetched through the pool.
+   */
+  PageGuard fetchForRead(size_t page, ScanRing *ring = nullptr) const;
+
 public:
   /**
    * @brief Construct a new Db File object with the specified file name and tuple descriptor
@@ -41,9 +91,63 @@ public:
 
   const std::string &getName() const;
 
-  const std::vector<size_t> &getReads() const;
+  file_id_t getId() const;
+
+  /**
+   * @brief Returns the trace of the page reads, which only retains page ids if enabled with `setTraceCapacity`.
+   */
+  const IoTrace &getReads() const;
 
-  const std::vector<size_t> &getWrites() const;
+  /**
+   * @brief Returns the trace of the page writes, which only retains page ids if enabled with `setTraceCapacity`.
+   */
+  const IoTrace &getWrites() const;
+
+  /**
+   * @brief Restart the traces of the reads and writes, retaining the page ids of the most recent accesses.
+   * @param capacity The number of page ids retained by each trace; 0 only counts the accesses.
+   * @note Must not be called while pages of the file are being read or written.
+   */
+  void setTraceCapacity(size_t capacity);
+
+  /**
+   * @brief Returns the I/O counters of the file since it was opened.
+   */
+  IoStats getIoStats() const;
+
+  /**
+   * @brief Enable or disable direct I/O, which bypasses the page cache of the OS.
+   * @details Sets O_DIRECT on the open file so pages are only cached by the BufferPool. Buffers that are not aligned to
+   * `DIRECT_IO_ALIGNMENT` (e.g. pages that are not frames of the pool) go through an aligned copy.
+   * @param enable Whether the file should use direct I/O.
+   * @return Whether the file uses direct I/O, which is false if the filesystem rejects O_DIRECT.
+   * @note Must not be called while pages of the file are being read or written.
+   */
+  bool setDirectIo(bool enable);
+
+  bool isDirectIo() const;
+
+  /**
+   * @brief Map the pages of the file read-only, so that reads that miss the BufferPool use the mapping directly.
+   * @details Pages appended after the file was mapped are read through the pool. Writes always go through the pool.
+   * @param pattern The access pattern hint for the mapping.
+   * @return Whether the file is mapped, which is false if it is empty or the mapping fails.
+   * @note Must not be called while pages of the file are being read.
+   */
+  bool map(AccessPattern pattern = AccessPattern::NORMAL);
+
+  /**
+   * @brief Removes the mapping, reads go through the BufferPool again.
+   * @note Must not be called while pages of the mapping are in use.
+   */
+  void unmap();
+
+  bool isMapped() const;
+
+  /**
+   * @brief Change the access pattern hint of the mapping.
+   */
+  void advise(AccessPattern pattern) const;
 
   /**
    * @brief Read a page from the file.
@@ -60,18 +164,69 @@ public:
    */
   void writePage(const Page &page, size_t id) const;
 
+  /**
+   * @brief Read several pages with a single batch of the I/O engine.
+   * @param pages The pages to read into.
+   * @param ids The page numbers, `pages[i]` receives page `ids[i]`.
+   */
+  void readPages(const std::vector<Page *> &pages, const std::vector<size_t> &ids) const;
+
+  /**
+   * @brief Write several pages with a single batch of the I/O engine.
+   * @param pages The pages to write, not necessarily adjacent in memory.
+   * @param ids The page numbers, `pages[i]` is written to page `ids[i]`.
+   * @note Pages that are adjacent in the file should be adjacent in `pages`, the POSIX engine merges them.
+   */
+  void writePages(const std::vector<const Page *> &pages, const std::vector<size_t> &ids) const;
+
   virtual void insertTuple(const Tuple &t);
 
+  /**
+   * @brief Insert a tuple that is already serialized, e.g. copied from another page by TupleView::serialize.
+   * @details Files that store rows as they are copy it without deserializing it. The default deserializes it and calls
+   * insertTuple.
+   * @param row The tuple serialized by TupleDesc::serialize with the TupleDesc of this file.
+   */
+  virtual void insertRow(const uint8_t *row);
+
   virtual void deleteTuple(const Iterator &it);
 
   virtual Tuple getTuple(const Iterator &it) const;
 
+  /**
+   * @brief Get a view of a tuple without deserializing it.
+   * @details Pins the page of the iterator in its guard if it is not pinned yet, the view is valid while it stays there.
+   * @param it The iterator that identifies the tuple to be read.
+   * @return The view of the tuple in the page.
+   */
+  virtual TupleView getTupleView(Iterator &it) const;
+
   virtual void next(Iterator &it) const;
 
+  /**
+   * @brief Read the tuples from the position of an iterator to the end of its page, or at most `max_rows` of them.
+   * @details The iterator is advanced past the returned tuples. A scan starts with `begin()` and calls this until it
+   * returns false, which pays for the page lookup and the page layout once per batch instead of once per tuple.
+   * @param it The position of the scan, advanced past the batch.
+   * @param batch Refilled with the next tuples, which are all in one page.
+   * @param max_rows The maximum size of the batch.
+   * @return Whether there were tuples left, false once the iterator is at the end.
+   */
+  virtual bool nextBatch(Iterator &it, PageBatch &batch, size_t max_rows = SIZE_MAX) const;
+
   virtual Iterator begin() const;
 
   virtual Iterator end() const;
 
+  /**
+   * @brief Start a scan that deserializes only some fields of every tuple.
+   * @details `*it` returns the listed fields, the views and batches of the scan still see the whole tuple.
+   * @param projection The indices of the fields, in the order they appear in the tuples of the scan.
+   * @return The iterator at the first tuple, which compares equal to `end()` when the scan is over.
+   * @throws std::out_of_range if an index is not a field.
+   */
+  Iterator scan(std::vector<size_t> projection) const;
+
   size_t getNumPages() const;
 
   const TupleDesc &getTupleDesc() const;
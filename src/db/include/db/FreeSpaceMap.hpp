@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace db {
+/**
+ * @brief A map of the free space of every page of a heap file, one byte per page.
+ * @details Each byte is a fullness class: 0 means the page has no room, and classes 1 to 255 are proportional to the
+ * free fraction of the page, rounded down so that a page has at least the room its class says. Each class has a cursor
+ * at the first page that may have room for it, so a search only passes over each page that is too full for its class
+ * once until space is freed before the cursor.
+ * @note The map is a hint: a page may have less room than its class says if the map was not saved, so callers must
+ * handle a failed insert by correcting the class of the page.
+ */
+class FreeSpaceMap {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  static constexpr uint8_t FULL = 0;
+
+  static constexpr uint8_t EMPTY = UINT8_MAX;
+
+private:
+  std::vector<uint8_t> classes;
+
+  /// No page before `cursors[c]` has class `c` or more
+  std::array<size_t, EMPTY + 1> cursors{};
+
+public:
+  /**
+   * @brief Returns the fullness class of a page, the free fraction of the page rounded down.
+   * @param free The free space of the page, in any unit.
+   * @param capacity The space of an empty page, in the same unit.
+   */
+  static uint8_t classify(size_t free, size_t capacity);
+
+  /// The number of pages in the map
+  size_t size() const;
+
+  /// Returns the class of a page, or FULL if the page is not in the map
+  uint8_t get(size_t page) const;
+
+  /**
+   * @brief Sets the class of a page, growing the map with FULL pages if the page is past its end.
+   */
+  void set(size_t page, uint8_t cls);
+
+  /**
+   * @brief Returns the first page of at least the specified class.
+   * @param cls The minimum class, at least 1.
+   * @param from The first page to consider, to continue a search past a page that did not have enough room.
+   * @return The page, or npos if no page has that much room.
+   */
+  size_t find(uint8_t cls = 1, size_t from = 0);
+
+  void clear();
+
+  /**
+   * @brief Replaces the map with the one saved in a file.
+   * @param path The file written by `save`.
+   * @param data The file the map describes. A map saved before this file was last modified may be out of date.
+   * @return Whether the map exists, is up to date and was read; the map is empty otherwise.
+   */
+  bool load(const std::string &path, const std::string &data);
+
+  /**
+   * @brief Writes the map to a file, replacing its contents.
+   * @return Whether the map was written.
+   */
+  bool save(const std::string &path) const;
+};
+} // namespace db
@@ -1,19 +1,74 @@
 #pragma once
 
 #include <db/DbFile.hpp>
+#include <db/FreeSpaceMap.hpp>
+#include <db/HeapPage.hpp>
+#include <ranges>
 
 namespace db {
+/// Number of pages a HeapLoader writes per batch
+constexpr size_t DEFAULT_LOAD_BATCH_PAGES = 256;
+
+/**
+ * @brief A database file of unordered tuples in HeapPages.
+ * @details Inserts go to the first page with room according to a FreeSpaceMap, so space freed by deletes is reused.
+ * The map is saved next to the file as `name + ".fsm"` when the file is closed, and rebuilt by scanning the pages if
+ * that file is missing or does not match the file. Scans skip the pages the map knows to be empty without reading them.
+ */
 class HeapFile : public DbFile {
+  const PageLayout layout;
+  FreeSpaceMap fsm;
+  bool fsm_loaded = false;
+
+  /// Load or rebuild the free space map before its first use
+  FreeSpaceMap &freeSpace();
+
+  /// Whether the free space map is loaded and has the page as EMPTY, so that it has no tuples
+  bool skip(size_t page) const;
+
+  friend class HeapLoader;
+
+  /**
+   * @brief Pin the page an iterator points to.
+   * @details Reuses the pin held by the iterator when it is on that page, so no buffer pool lookup is needed.
+   * @param write Whether the page will be modified, in which case it is pinned in the buffer pool even if it is mapped.
+   */
+  PageGuard pin(const Iterator &it, bool write) const;
+
+  /// Calls `insert(HeapPage &)` on the pages of at least class `cls` until it returns true, then on a new page
+  template <typename Insert> void insert(uint8_t cls, Insert &&insert);
+
 public:
-  HeapFile(const std::string &name, const TupleDesc &td);
+  /**
+   * @param name The name of the file to be opened or created.
+   * @param td The tuple descriptor of the tuples in the file.
+   * @param layout The arrangement of the tuples in every page, which must be the same every time the file is opened.
+   */
+  HeapFile(const std::string &name, const TupleDesc &td, PageLayout layout = PageLayout::ROW);
+
+  /**
+   * @brief Saves the free space map.
+   */
+  ~HeapFile() override;
+
+  PageLayout getLayout() const;
 
   /**
    * @brief Insert a tuple to the database file.
-   * @details Insert a tuple to the first available slot of the last page. If the last page is full, create a new page.
+   * @details Insert a tuple to the first available slot of the first page with room. If every page is full, create a
+   * new page.
    * @param t The tuple to be inserted.
    */
   void insertTuple(const Tuple &t) override;
 
+  void insertRow(const uint8_t *row) override;
+
+  /**
+   * @brief Append a range of tuples to new pages of the file, see HeapLoader.
+   * @param tuples The tuples to be inserted.
+   */
+  template <std::ranges::input_range R> void bulkLoad(R &&tuples);
+
   /**
    * @brief Delete a tuple from the database file.
    * @details Delete a tuple from the database file by marking the slot unused.
@@ -29,6 +84,8 @@ public:
    */
   Tuple getTuple(const Iterator &it) const override;
 
+  TupleView getTupleView(Iterator &it) const override;
+
   /**
    * @brief Advance the iterator to the next tuple.
    * @details Advance the iterator to the next tuple by moving to the next slot of the page.
@@ -37,6 +94,8 @@ public:
    */
   void next(Iterator &it) const override;
 
+  bool nextBatch(Iterator &it, PageBatch &batch, size_t max_rows = SIZE_MAX) const override;
+
   /**
    * @brief Get the iterator to the first tuple.
    * @details Get the iterator to the first tuple by finding the first occupied slot.
@@ -52,4 +111,68 @@ public:
    */
   Iterator end() const override;
 };
+
+/**
+ * @brief Appends a stream of tuples to a HeapFile, filling new pages in memory and writing them without the BufferPool.
+ * @details Tuples go to consecutive slots of pages that follow the last page of the file (or replace its only page if
+ * it is empty), so no slot is searched and no page is looked up. Full pages are written in batches of adjacent pages,
+ * which the I/O engine merges into large writes, and become part of the file once they are written.
+ * @note No other tuples may be inserted into the file while it is being loaded.
+ */
+class HeapLoader {
+  HeapFile &file;
+  std::vector<AlignedPage> batch;
+  /// The page number of `batch[0]`
+  size_t first;
+  /// The pages of the batch in use, the last one is being filled
+  size_t count = 0;
+  /// The next slot of the page being filled
+  size_t slot = 0;
+  size_t capacity;
+  size_t tuples = 0;
+
+  /// Writes the pages of the batch, registers them in the file and starts a new batch
+  void write();
+
+  /// Adds a tuple to the page being filled, returns false if it is full
+  bool add(const Tuple &t);
+
+public:
+  /**
+   * @param file The file to append to.
+   * @param batch_pages The number of pages written at once.
+   */
+  explicit HeapLoader(HeapFile &file, size_t batch_pages = DEFAULT_LOAD_BATCH_PAGES);
+
+  /**
+   * @brief Writes the remaining tuples, errors are only reported by finish.
+   */
+  ~HeapLoader();
+
+  HeapLoader(const HeapLoader &) = delete;
+
+  HeapLoader &operator=(const HeapLoader &) = delete;
+
+  /**
+   * @brief Append a tuple.
+   * @throws std::runtime_error if the tuple is not compatible with the file.
+   */
+  void append(const Tuple &t);
+
+  /**
+   * @brief Write the page that is being filled and the rest of the batch.
+   */
+  void finish();
+
+  /// The number of tuples appended
+  size_t size() const;
+};
+
+template <std::ranges::input_range R> void HeapFile::bulkLoad(R &&tuples) {
+  HeapLoader loader(*this);
+  for (const Tuple &t : tuples) {
+    loader.append(t);
+  }
+  loader.finish();
+}
 } // namespace db
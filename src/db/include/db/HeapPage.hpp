@@ -3,22 +3,95 @@
 #include <db/DbFile.hpp>
 
 namespace db {
+/**
+ * @brief The arrangement of the tuples in the data area of a HeapPage.
+ * @details ROW and PAX pages have the same header and capacity.
+ */
+enum class PageLayout {
+  /// (NSM) Each tuple is stored as a contiguous record
+  ROW,
+  /**
+   * The values of each column are stored contiguously in a minipage: column `i` of slot `s` is at
+   * `data + capacity * td.offset_of(i) + s * td.width_of(i)`, and the null bitmap of slot `s`, if any, at
+   * `data + s * td.bitmap_length()`
+   */
+  PAX,
+  /**
+   * Records of any length: a directory of (offset, length) entries follows a small header, and the records fill the
+   * page from its end. The only layout of tuples with VARCHAR fields.
+   */
+  SLOTTED
+};
+
 class HeapPage {
+  /// The header of a SLOTTED page
+  struct SlotHeader {
+    /// The number of entries of the directory, which is the end of the page
+    uint16_t count;
+    /// The start of the records, or 0 if the page has never held one
+    uint16_t free_end;
+  };
+
+  /// An entry of the directory of a SLOTTED page, the offset of an empty slot is 0
+  struct SlotEntry {
+    uint16_t offset;
+    uint16_t length;
+  };
+
   const TupleDesc &td;
+  PageLayout layout;
   size_t capacity;
   uint8_t *header;
   uint8_t *data;
 
+  /// The header and directory of a SLOTTED page, which start at `header`
+  SlotHeader *slot_header = nullptr;
+  SlotEntry *directory = nullptr;
+
+  /// Marks the first empty slot as occupied and returns it, or returns `capacity` if the page is full
+  size_t claim();
+
+  /// Serialize a tuple to an empty slot
+  void write(size_t slot, const Tuple &t);
+
+  /// Copy a serialized tuple to an empty slot
+  void write(size_t slot, const uint8_t *row);
+
+  /// Returns the header bits of slots `64 * i` to `64 * i + 63`, the first slot in the most significant bit
+  uint64_t word(size_t i) const;
+
+  /**
+   * @brief Find the first slot at or after `slot` that is occupied, or empty if `occupied` is false.
+   * @return The slot, or capacity if there is none.
+   */
+  size_t find(size_t slot, bool occupied) const;
+
+  /// The bytes of the live records of a SLOTTED page
+  size_t usedBytes() const;
+
+  /// The start of the records of a SLOTTED page
+  size_t recordStart() const;
+
+  /// Moves the records of a SLOTTED page to the end of the page, so that the free space between them is contiguous
+  void compact();
+
+  /**
+   * @brief Copy a record to an empty slot of a SLOTTED page, or to a new slot at its end.
+   * @return False if the page does not have room for the record, and its directory entry if it is new.
+   */
+  bool place(size_t slot, const uint8_t *row, size_t length);
+
 public:
   /**
    * @brief Wrap a page with a heap page.
    * @details Wrap a page with a heap page by initializing the header and data pointers.
    * @param page The page to be wrapped.
    * @param td The tuple descriptor of the page.
+   * @param layout The arrangement of the tuples in the page.
    * @note header and data should point to locations inside the page buffer. Do not allocate extra memory.
    * @note initialize capacity to the number of slots that can fit in the page.
    */
-  HeapPage(Page &page, const TupleDesc &td);
+  HeapPage(Page &page, const TupleDesc &td, PageLayout layout = PageLayout::ROW);
 
   /**
    * @brief Get the first occupied slot of the page.
@@ -40,6 +113,23 @@ public:
    */
   bool insertTuple(const Tuple &t);
 
+  /**
+   * @brief Insert a tuple that is already serialized.
+   * @details The row is copied to the page as is, or scattered to the columns of a PAX page.
+   * @param row The tuple serialized by TupleDesc::serialize with the TupleDesc of the page.
+   * @return True if the tuple is inserted successfully, false otherwise if the page is full.
+   */
+  bool insertRow(const uint8_t *row);
+
+  /**
+   * @brief Insert a tuple to a specific slot of the page.
+   * @details Used to fill pages sequentially without searching for a free slot.
+   * @param slot The slot, which must be empty.
+   * @param t The tuple to be inserted.
+   * @throws std::runtime_error if the slot is out of range or occupied.
+   */
+  void insertTuple(size_t slot, const Tuple &t);
+
   /**
    * @brief Delete a tuple from the page.
    * @details Delete a tuple from the page by marking the slot unused.
@@ -55,6 +145,32 @@ public:
    */
   bool empty(size_t slot) const;
 
+  /**
+   * @brief Count the occupied slots of the page.
+   * @details The count is computed once per HeapPage, a word of the header at a time.
+   * @return The number of tuples in the page.
+   */
+  size_t size() const;
+
+  /**
+   * @brief Count the empty slots of the page.
+   * @return The number of tuples that can still be inserted, or the number of empty directory entries of a SLOTTED page.
+   */
+  size_t freeSlots() const;
+
+  /**
+   * @brief Get the class of the page in a FreeSpaceMap.
+   * @details The free slots of the page, or the free bytes of a SLOTTED page, relative to an empty page. A page with a
+   * free slot has at least class 1, and a SLOTTED page has room for a record if its class is at least requiredClass.
+   */
+  uint8_t freeClass() const;
+
+  /**
+   * @brief Get the least class a SLOTTED page with room for a record can have in a FreeSpaceMap.
+   * @param length The length of the serialized record.
+   */
+  static uint8_t requiredClass(size_t length);
+
   /**
    * @brief Get the tuple at the specified slot.
    * @details Get the tuple at the specified slot by deserializing the tuple from the page.
@@ -63,6 +179,39 @@ public:
    */
   Tuple getTuple(size_t slot) const;
 
+  /**
+   * @brief Get some fields of the tuple at the specified slot.
+   * @details Only the listed fields are deserialized from the page.
+   * @param slot The slot of the tuple to be deserialized.
+   * @param indices The indices of the fields, in the order they appear in the result.
+   * @return The projected tuple read from the page.
+   */
+  Tuple getTuple(size_t slot, const std::vector<size_t> &indices) const;
+
+  /**
+   * @brief Get a view of the tuple at the specified slot.
+   * @details The view points into the page, no field is decoded.
+   * @param slot The slot of the tuple.
+   * @return The view of the tuple, valid while the page is.
+   */
+  TupleView getView(size_t slot) const;
+
+  /**
+   * @brief Get the start of the tuples: slot `i` is serialized at `getData() + i * td.length()` in a ROW page, and the
+   * columns start at `getData() + end() * td.offset_of(c)` in a PAX page. In a SLOTTED page, it is the start of the page
+   * and the offsets of the records are in the directory.
+   */
+  const uint8_t *getData() const;
+
+  /**
+   * @brief Get the directory of a SLOTTED page: the record of slot `i` starts at `getData() + getDirectory()[2 * i]`
+   * and is `getDirectory()[2 * i + 1]` bytes long.
+   * @return The directory, or nullptr if the page is not SLOTTED.
+   */
+  const uint16_t *getDirectory() const;
+
+  PageLayout getLayout() const;
+
   /**
    * @brief Advance the slot to the next occupied slot.
    * @details Advance the slot to the next occupied slot by scanning the header.
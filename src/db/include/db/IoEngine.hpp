@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace db {
+constexpr size_t DEFAULT_IO_DEPTH = 32;
+
+/**
+ * @brief The I/O engines that can perform page reads and writes.
+ * @details POSIX performs one blocking system call per request, merging requests for adjacent pages into a single
+ * preadv/pwritev. IO_URING submits a whole batch with one io_uring_enter call and waits for all of its completions,
+ * so the kernel can serve the requests in parallel.
+ */
+enum class IoEngineType { POSIX, IO_URING };
+
+/**
+ * @brief A read or write of a buffer at an offset of a file.
+ */
+struct IoRequest {
+  enum class Op : uint8_t { READ, WRITE };
+
+  Op op;
+  int fd;
+  uint8_t *data;
+  size_t length;
+  off_t offset;
+};
+
+/**
+ * @brief Performs batches of file I/O requests.
+ * @details Reads past the end of a file complete with fewer bytes, the rest of the buffer is left unchanged.
+ * Any other partial transfer, such as a write interrupted by a signal, is resumed until the request completes.
+ * @note An engine is not thread-safe. DbFile uses the engine of the calling thread, returned by `local`.
+ */
+class IoEngine {
+public:
+  virtual ~IoEngine() = default;
+
+  /**
+   * @brief Performs the requests and returns once all of them completed.
+   * @throws std::runtime_error if a request fails.
+   */
+  virtual void submit(const std::vector<IoRequest> &requests) = 0;
+
+  /**
+   * @brief Returns the backend of the engine, which is POSIX if the requested backend was unavailable.
+   */
+  virtual IoEngineType type() const = 0;
+
+  /**
+   * @brief Create an engine.
+   * @param type The requested backend.
+   * @param queue_depth The maximum number of requests in flight.
+   * @return The requested engine, or a POSIX engine if the backend is not supported by the kernel.
+   */
+  static std::unique_ptr<IoEngine> create(IoEngineType type, size_t queue_depth);
+
+  /**
+   * @brief Select the engine used by the threads that perform file I/O from now on.
+   */
+  static void setDefault(IoEngineType type, size_t queue_depth);
+
+  /**
+   * @brief Returns the engine of the calling thread, created with the default backend on first use.
+   */
+  static IoEngine &local();
+};
+
+/**
+ * @brief Blocking pread/pwrite, with requests for adjacent pages merged into preadv/pwritev.
+ */
+class PosixIoEngine : public IoEngine {
+public:
+  void submit(const std::vector<IoRequest> &requests) override;
+
+  IoEngineType type() const override;
+};
+
+/**
+ * @brief io_uring through the raw system calls: one submission queue entry per request.
+ * @details Batches larger than the queue depth are submitted in chunks of the queue depth.
+ */
+class IoUringEngine : public IoEngine {
+  int ring_fd = -1;
+  unsigned depth;
+  void *sq_ring = nullptr;
+  size_t sq_ring_size = 0;
+  void *cq_ring = nullptr;
+  size_t cq_ring_size = 0;
+  void *sqes = nullptr;
+  size_t sqes_size = 0;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  void *cqes;
+
+  void unmap();
+
+public:
+  /**
+   * @throws std::system_error if the kernel does not support io_uring, or its read and write operations.
+   */
+  explicit IoUringEngine(unsigned depth);
+
+  ~IoUringEngine() override;
+
+  IoUringEngine(const IoUringEngine &) = delete;
+
+  IoUringEngine &operator=(const IoUringEngine &) = delete;
+
+  void submit(const std::vector<IoRequest> &requests) override;
+
+  IoEngineType type() const override;
+};
+} // namespace db
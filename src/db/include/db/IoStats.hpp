@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace db {
+/**
+ * @brief A snapshot of a LatencyHistogram.
+ * @details Bucket 0 counts latencies below 1us, bucket `k` latencies in [2^(k-1), 2^k) us. The last bucket also
+ * counts everything above its lower bound.
+ */
+struct LatencyCounts {
+  static constexpr size_t NUM_BUCKETS = 24;
+
+  std::array<size_t, NUM_BUCKETS> buckets{};
+
+  /// Sum of the recorded latencies
+  std::chrono::nanoseconds total{0};
+
+  /// Returns the bucket that counts a latency
+  static size_t bucket(std::chrono::nanoseconds latency);
+
+  /// Records a latency, for counts that are guarded by a latch
+  void record(std::chrono::nanoseconds latency);
+
+  /// Total number of recorded latencies
+  size_t count() const;
+
+  /// Average of the recorded latencies, or 0 if nothing was recorded
+  std::chrono::nanoseconds mean() const;
+
+  LatencyCounts &operator+=(const LatencyCounts &other);
+
+  /**
+   * @brief Returns an upper bound of the latency below which a fraction `q` of the recorded latencies fall.
+   * @param q The quantile in [0, 1].
+   * @return The upper bound of the bucket that contains the quantile, or 0 if nothing was recorded.
+   */
+  std::chrono::microseconds quantile(double q) const;
+};
+
+/**
+ * @brief A cumulative histogram of latencies with power-of-two microsecond buckets.
+ * @note Recording is wait-free and the histogram has a fixed size.
+ */
+class LatencyHistogram {
+  std::array<std::atomic<size_t>, LatencyCounts::NUM_BUCKETS> buckets{};
+  std::atomic<int64_t> total_ns = 0;
+
+public:
+  void record(std::chrono::nanoseconds latency);
+
+  LatencyCounts snapshot() const;
+};
+
+/**
+ * @brief A snapshot of the I/O counters of a DbFile.
+ */
+struct IoStats {
+  size_t pages_read = 0;
+  size_t pages_written = 0;
+  size_t bytes_read = 0;
+  size_t bytes_written = 0;
+
+  /// Latencies of the read batches, one per readPage or readPages call
+  LatencyCounts read_latency;
+
+  /// Latencies of the write batches, one per writePage or writePages call
+  LatencyCounts write_latency;
+};
+
+/**
+ * @brief A bounded record of the page ids of the most recent reads or writes of a file, for debugging.
+ * @details Every access is counted, but only the last `capacity` page ids are kept. Entry `i` is the page id of the
+ * `i`-th access since the trace was enabled, if it is still retained. The capacity is 0 unless enabled.
+ * @note Recording is thread-safe. An entry that is overwritten while it is read may be torn between two accesses.
+ */
+class IoTrace {
+  std::atomic<size_t> recorded = 0;
+  std::unique_ptr<std::atomic<size_t>[]> entries;
+  size_t capacity = 0;
+
+public:
+  /**
+   * @brief Discards the trace and retains the page ids of the next `capacity` accesses from now on.
+   * @note Must not be called while the file is being read or written.
+   */
+  void reset(size_t capacity);
+
+  void record(size_t id);
+
+  void record(const std::vector<size_t> &ids);
+
+  /// The number of accesses since the trace was reset, including the ones no longer retained
+  size_t size() const;
+
+  /**
+   * @brief Returns the page id of access `i`.
+   * @throws std::out_of_range if the entry is not retained.
+   */
+  size_t operator[](size_t i) const;
+
+  /// The retained page ids, oldest first
+  std::vector<size_t> retained() const;
+};
+} // namespace db
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <db/BufferPool.hpp>
 #include <db/Tuple.hpp>
 
 namespace db {
@@ -10,17 +11,101 @@ struct Iterator {
   size_t page;
   size_t slot;
 
+  /// The pinned current page, kept by the file so that advancing within a page needs no buffer pool lookup.
+  /// It may be empty or refer to a different page if `page` was changed directly.
+  PageGuard guard;
+
+  /// The frames the scan cycles through, shared by copies of the iterator. Empty if scan rings are disabled.
+  std::shared_ptr<ScanRing> ring;
+
+  /// The sequential access detection of the scan, shared by copies of the iterator. Empty if read-ahead is disabled.
+  std::shared_ptr<ReadAhead> read_ahead;
+
+  /// The fields that `*it` deserializes, in order, set by DbFile::scan. Empty for all fields.
+  std::vector<size_t> projection;
+
 public:
-  Iterator(const DbFile &file, const size_t &page, size_t slot);
+  Iterator(const DbFile &file, const size_t &page, size_t slot, PageGuard guard = {},
+           std::shared_ptr<ScanRing> ring = {}, std::shared_ptr<ReadAhead> read_ahead = {});
   ~Iterator() = default;
   Iterator(const Iterator &) = default;
   Iterator(Iterator &&) = default;
 
   Tuple operator*() const;
 
+  /**
+   * @brief Returns a view of the current tuple, which stays valid until the iterator moves to another page.
+   */
+  TupleView view();
+
   Iterator &operator++();
 
   bool operator==(const Iterator &other) const { return page == other.page && slot == other.slot; }
   bool operator!=(const Iterator &) const = default;
 };
-} // namespace db
\ No newline at end of file
+
+/**
+ * @brief The live tuples of one page, filled by DbFile::nextBatch.
+ * @details The batch pins its page, so the views of its tuples stay valid until the batch is refilled or destroyed.
+ * Field `c` of slot `s` is at `column(c) + s * columnStride(c)` in both row and PAX pages, so a column can be read
+ * without decoding the tuples. Slotted pages have no columns, field reads go through the directory.
+ */
+struct PageBatch {
+  /// The pinned page the tuples are in
+  PageGuard page;
+
+  const TupleDesc *td = nullptr;
+
+  /// The serialized tuple of slot `s` starts at `data + s * stride` in a row page
+  const uint8_t *data = nullptr;
+  size_t stride = 0;
+
+  /// The slots per column of a PAX page, whose columns start at `data + capacity * td->offset_of(c)`; 0 for rows
+  size_t capacity = 0;
+
+  /// The directory of a slotted page, see HeapPage::getDirectory; `data` is the start of the page. Null otherwise.
+  const uint16_t *directory = nullptr;
+
+  /// The selection vector: the live slots of the batch, in scan order
+  std::vector<size_t> slots;
+
+  size_t size() const { return slots.size(); }
+
+  bool empty() const { return slots.empty(); }
+
+  /// The view of the `i`-th tuple of the batch
+  TupleView view(size_t i) const {
+    if (directory != nullptr) {
+      return {*td, data + directory[2 * slots[i]]};
+    }
+    return capacity == 0 ? TupleView(*td, data + slots[i] * stride) : TupleView(*td, data, capacity, slots[i]);
+  }
+
+  /// The field `c` of slot 0, see columnStride. Not for slotted pages.
+  const uint8_t *column(size_t c) const {
+    return capacity == 0 ? data + td->offset_of(c) : data + capacity * td->offset_of(c);
+  }
+
+  /// The distance between the fields `c` of consecutive slots, which is the width of the field in a PAX page
+  size_t columnStride(size_t c) const { return capacity == 0 ? stride : td->width_of(c); }
+
+  /// The serialized field `c` of the `i`-th tuple of the batch, in any page layout
+  const uint8_t *field(size_t c, size_t i) const {
+    if (directory != nullptr) {
+      return data + directory[2 * slots[i]] + td->offset_of(c);
+    }
+    return column(c) + slots[i] * columnStride(c);
+  }
+
+  /// The null bitmap of the `i`-th tuple of the batch, in any page layout, see TupleDesc::bitmap_length
+  const uint8_t *nulls(size_t i) const {
+    if (directory != nullptr) {
+      return data + directory[2 * slots[i]];
+    }
+    return capacity == 0 ? data + slots[i] * stride : data + slots[i] * td->bitmap_length();
+  }
+
+  /// Releases the page and empties the batch
+  void clear();
+};
+} // namespace db
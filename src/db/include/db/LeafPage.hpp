@@ -57,6 +57,13 @@ struct LeafPage {
    * @return The tuple read from the page.
    */
   Tuple getTuple(size_t slot) const;
+
+  /**
+   * @brief Get a view of a tuple, without decoding its fields.
+   * @param slot The slot of the tuple.
+   * @return The view of the tuple, valid while the page is.
+   */
+  TupleView getView(size_t slot) const;
 };
 
 } // namespace db
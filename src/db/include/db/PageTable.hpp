@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <db/types.hpp>
+#include <vector>
+
+namespace db {
+/**
+ * @brief A fixed-capacity hash table from page ids to frame positions.
+ * @details Open addressing with linear probing over a power-of-two array that is at most half full, so a lookup
+ * usually reads a single cache line of 16-byte slots. Erasing shifts the following entries of the probe sequence back
+ * instead of leaving tombstones, so lookups never slow down as pages come and go.
+ * @note The table never grows: it holds at most the number of entries it was constructed for.
+ */
+class PageTable {
+  struct alignas(16) Slot {
+    file_id_t file;
+    uint32_t pos;
+    size_t page;
+  };
+
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  std::vector<Slot> slots;
+  size_t mask;
+  size_t count = 0;
+
+  size_t home(const PageId &pid) const { return std::hash<const PageId>()(pid) & mask; }
+
+  /// Returns the slot of `pid`, or the empty slot that ends its probe sequence
+  size_t probe(const PageId &pid) const;
+
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @param capacity The maximum number of entries, which must be less than 2^32 - 1.
+   */
+  explicit PageTable(size_t capacity);
+
+  /**
+   * @brief Returns the position of a page, or npos if it is not in the table.
+   */
+  size_t find(const PageId &pid) const;
+
+  /**
+   * @brief Returns the position of a page.
+   * @throws std::out_of_range if the page is not in the table.
+   */
+  size_t at(const PageId &pid) const;
+
+  bool contains(const PageId &pid) const { return find(pid) != npos; }
+
+  /**
+   * @brief Maps a page to a position, replacing its previous position if it is already in the table.
+   * @throws std::length_error if the table is full.
+   */
+  void insert(const PageId &pid, size_t pos);
+
+  /**
+   * @brief Removes a page.
+   * @return Whether the page was in the table.
+   */
+  bool erase(const PageId &pid);
+
+  size_t size() const { return count; }
+};
+} // namespace db
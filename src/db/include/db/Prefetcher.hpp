@@ -0,0 +1,138 @@
+#pragma once
+
+#include <condition_variable>
+#include <db/types.hpp>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace db {
+class BufferPool;
+class DbFile;
+
+/**
+ * @brief Counters of the asynchronous read-ahead of a BufferPool.
+ */
+struct PrefetchStats {
+  /// Pages read from disk by the prefetcher
+  size_t issued = 0;
+
+  /// Fetches that found a prefetched page already loaded
+  size_t hits = 0;
+
+  /// Fetches of a requested page that was not loaded yet, so the caller read it or waited for it
+  size_t misses = 0;
+
+  /// Prefetched pages that were evicted or discarded before any fetch used them
+  size_t wasted = 0;
+};
+
+/**
+ * @brief A page read requested ahead of a scan.
+ * @details After loading `pid`, the prefetcher continues with the page returned by `successor` until `remaining`
+ * further pages were requested or the successor is `npos`.
+ */
+struct PrefetchRequest {
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  const DbFile *file;
+  PageId pid;
+
+  /// The number of pages to follow after this one
+  size_t remaining = 0;
+
+  /// Returns the page that follows a loaded page, or npos. If empty, pages are followed in file order.
+  std::function<size_t(const Page &)> successor;
+};
+
+/**
+ * @brief A background thread that loads the pages requested by scans into a BufferPool.
+ * @details Requests are served in FIFO order by a single worker, which passes up to `batch` queued requests at a time
+ * to the load function of the pool without holding the prefetcher latch. The load function returns the requests for
+ * the next pages of the chains.
+ */
+class Prefetcher {
+public:
+  using Load = std::function<std::vector<PrefetchRequest>(const std::vector<PrefetchRequest> &)>;
+
+private:
+  std::mutex latch;
+  std::condition_variable ready;
+  std::condition_variable idle;
+  std::deque<PrefetchRequest> queue;
+  std::vector<const DbFile *> current;
+  bool stopping = false;
+  Load load;
+  size_t batch;
+  std::thread worker;
+
+  void run();
+
+public:
+  Prefetcher(Load load, size_t batch);
+
+  /**
+   * @brief Stops the worker. Requests that were not served yet are dropped.
+   */
+  ~Prefetcher();
+
+  Prefetcher(const Prefetcher &) = delete;
+
+  Prefetcher &operator=(const Prefetcher &) = delete;
+
+  /**
+   * @brief Queues a request.
+   */
+  void submit(PrefetchRequest request);
+
+  /**
+   * @brief Removes the queued request for a page that is about to be read by a fetch.
+   * @details A request that other pages follow stays queued, since the rest of the chain starts from it.
+   * @return Whether a request for the page was queued.
+   */
+  bool take(const PageId &pid);
+
+  /**
+   * @brief Drops the queued requests of a file and waits until the worker is done with the file.
+   * @note Must be called before the file is destroyed.
+   */
+  void cancel(const DbFile &file);
+};
+
+/**
+ * @brief Sequential access detection for one scan.
+ * @details The scan reports every page it moves to. Once it moves from a page to the page that follows it, the scan is
+ * sequential and the next `window` pages are requested from the prefetcher of the pool. Whenever the scan has consumed
+ * half of the requested pages, the window is extended again, so the requests stay ahead of the scan.
+ */
+class ReadAhead {
+  BufferPool &pool;
+  const DbFile &file;
+  size_t window;
+  size_t expected = PrefetchRequest::npos;
+  /// The number of pages after the current one that were already requested
+  size_t ahead = 0;
+
+  /// Moves the scan to `page` and returns whether more pages should be requested
+  bool step(size_t page, size_t next);
+
+public:
+  ReadAhead(BufferPool &pool, const DbFile &file, size_t window);
+
+  /**
+   * @brief The scan moved to a page of a file whose pages are read in file order.
+   * @param page The new page of the scan.
+   */
+  void advance(size_t page);
+
+  /**
+   * @brief The scan moved to a page of a file whose page order is stored in the pages (e.g. B-tree leaves).
+   * @param page The new page of the scan.
+   * @param next The page that follows `page`, or npos if it is the last one.
+   * @param successor Returns the page that follows a loaded page, or npos.
+   */
+  void advance(size_t page, size_t next, const std::function<size_t(const Page &)> &successor);
+};
+} // namespace db
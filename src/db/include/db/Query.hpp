@@ -79,6 +79,7 @@ void projection(const DbFile &in, DbFile &out, const std::vector<std::string> &f
  * @brief Perform a filter operation.
  * @details A filter operation selects rows that satisfy a set of predicates.
  *   The predicates are combined with a logical AND.
+ *   A comparison with a NULL field or value is unknown, so the row is not selected.
  *   The output table is stored in the out table.
  * @param in The input table.
  * @param out The output table.
@@ -89,6 +90,7 @@ void filter(const DbFile &in, DbFile &out, const std::vector<FilterPredicate> &p
 /**
  * @brief Perform a join operation.
  * @details A join operation combines rows from two tables that satisfy the join predicates.
+ *   Rows whose join field is NULL match no row.
  *   The output table is stored in the out table.
  * @param left The left table.
  * @param right The right table.
@@ -109,6 +111,8 @@ void join(const DbFile &left, const DbFile &right, DbFile &out, const JoinPredic
  * @param out The output table.
  * @param agg The aggregate operation.
  * @note The computed value should have the same type as the field being aggregated with the exception of AVG which should return a double.
+ * @note NULL fields are skipped. COUNT counts the fields that are not NULL, the other operations return NULL if there is
+ * no such field, so the result field of the output table should be nullable.
  */
 void aggregate(const DbFile &in, DbFile &out, const Aggregate &agg);
 
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace db {
+
+/**
+ * @brief The page replacement algorithms available to a BufferPool.
+ * @details
+ *   LRU evicts the least recently used frame.
+ *   CLOCK approximates LRU with a reference bit per frame and a sweeping hand.
+ *   TWO_Q keeps pages that were referenced once in a FIFO queue and only admits them to the main LRU queue when they
+ *   are referenced again, so a large scan cannot flush the hot pages.
+ */
+enum class ReplacementPolicyType { LRU, CLOCK, TWO_Q };
+
+/**
+ * @brief Decides which frame of a BufferPool shard to evict.
+ * @details The policy tracks frame positions of one shard. The shard reports every frame that receives a page, every
+ * hit and every frame that is emptied, and asks for a victim when it runs out of free frames.
+ * @note A policy is not thread-safe; it is guarded by the latch of its shard.
+ */
+class ReplacementPolicy {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  virtual ~ReplacementPolicy() = default;
+
+  /**
+   * @brief A page was loaded into a free frame.
+   * @param pos The frame position.
+   * @param key A hash of the page id, used by policies that remember pages after eviction.
+   */
+  virtual void insert(size_t pos, size_t key) = 0;
+
+  /**
+   * @brief The page in a frame was accessed again.
+   * @param pos The frame position.
+   */
+  virtual void touch(size_t pos) = 0;
+
+  /**
+   * @brief The frame no longer holds a page.
+   * @param pos The frame position.
+   */
+  virtual void erase(size_t pos) = 0;
+
+  /**
+   * @brief Make a tracked frame one of the next eviction candidates, e.g. for pages unlikely to be accessed again.
+   * @param pos The frame position.
+   */
+  virtual void demote(size_t pos) = 0;
+
+  /**
+   * @brief Choose the frame to evict.
+   * @param evictable Whether a frame may be evicted (e.g. it is not pinned).
+   * @return The position of the frame to evict, or npos if no tracked frame is evictable.
+   * @note The caller evicts the frame and calls erase for it.
+   */
+  virtual size_t victim(const std::function<bool(size_t)> &evictable) = 0;
+
+  /**
+   * @brief List the frames that are next in line for eviction, without changing the state of the policy.
+   * @param n The maximum number of frames to list.
+   * @param out Receives the frame positions, coldest first.
+   */
+  virtual void coldest(size_t n, std::vector<size_t> &out) const = 0;
+
+  /**
+   * @brief Create a policy for a shard.
+   * @param type The replacement algorithm.
+   * @param num_frames The number of frames in the shard.
+   */
+  static std::unique_ptr<ReplacementPolicy> create(ReplacementPolicyType type, size_t num_frames);
+};
+
+/**
+ * @brief Least recently used replacement with an intrusive doubly linked list over frame positions.
+ */
+class LruPolicy : public ReplacementPolicy {
+  std::vector<size_t> prev;
+  std::vector<size_t> next;
+  size_t head = npos;
+  size_t tail = npos;
+
+  void pushFront(size_t pos);
+
+  void pushBack(size_t pos);
+
+  void unlink(size_t pos);
+
+public:
+  explicit LruPolicy(size_t num_frames);
+
+  void insert(size_t pos, size_t key) override;
+
+  void touch(size_t pos) override;
+
+  void erase(size_t pos) override;
+
+  void demote(size_t pos) override;
+
+  size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+  void coldest(size_t n, std::vector<size_t> &out) const override;
+};
+
+/**
+ * @brief CLOCK (second chance) replacement.
+ * @details A hit only sets the reference bit of the frame in a flat array. The hand sweeps the frames, clearing set
+ * bits and evicting the first evictable frame whose bit is clear.
+ */
+class ClockPolicy : public ReplacementPolicy {
+  std::vector<uint8_t> referenced;
+  std::vector<uint8_t> tracked;
+  size_t hand = 0;
+
+public:
+  explicit ClockPolicy(size_t num_frames);
+
+  void insert(size_t pos, size_t key) override;
+
+  void touch(size_t pos) override;
+
+  void erase(size_t pos) override;
+
+  void demote(size_t pos) override;
+
+  size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+  void coldest(size_t n, std::vector<size_t> &out) const override;
+};
+
+/**
+ * @brief 2Q replacement (after Johnson and Shasha).
+ * @details New pages enter the A1in FIFO queue and move to the Am LRU queue on their next hit. Pages evicted from A1in
+ * are remembered by key in the bounded A1out ghost queue, and a page that misses while remembered is loaded directly
+ * into Am. A1in is drained first once it holds more than a quarter of the frames, so a scan of pages that are
+ * referenced once can displace at most that many Am pages. A1out remembers half as many pages as there are frames.
+ * A1out is a ring of keys with an open-addressing index, both sized in the constructor, so remembering a page never
+ * allocates.
+ * @note Unlike the original algorithm, a hit in A1in promotes the page. The heap and B-tree iterators pin the current
+ * page, so the correlated references that the original guards against (several tuples of one page) are already
+ * collapsed into a single access.
+ */
+class TwoQueuePolicy : public ReplacementPolicy {
+  enum class Queue : uint8_t { NONE, A1IN, AM };
+
+  struct List {
+    size_t head = npos;
+    size_t tail = npos;
+    size_t size = 0;
+  };
+
+  std::vector<size_t> prev;
+  std::vector<size_t> next;
+  std::vector<Queue> queue;
+  std::vector<size_t> keys;
+  List a1in;
+  List am;
+  size_t kin;
+  size_t kout;
+  /// An entry of the A1out index: a remembered key and the ticket of its entry in the ring
+  struct Ghost {
+    size_t key;
+    size_t ticket;
+  };
+
+  /// The remembered keys, oldest first, at `ticket % size`. An entry is stale once the index has another ticket for
+  /// its key, because the key was remembered again or forgotten. Twice as large as A1out, so stale entries fit.
+  std::vector<size_t> a1out;
+  size_t a1out_head = 0;
+  size_t a1out_tail = 0;
+  /// The live keys of A1out, with linear probing over a power-of-two array that is at most half full
+  std::vector<Ghost> a1out_keys;
+  size_t a1out_mask;
+  size_t a1out_size = 0;
+
+  List &listOf(Queue q);
+
+  void pushFront(Queue q, size_t pos);
+
+  void pushBack(Queue q, size_t pos);
+
+  void unlink(size_t pos);
+
+  void remember(size_t key);
+
+  /// Returns the index slot of `key`, or the empty slot that ends its probe sequence
+  size_t ghostSlot(size_t key) const;
+
+  /// Removes the key in an index slot, its ring entry becomes stale
+  void forget(size_t slot);
+
+  /// Drops the stale entries of the ring, keeping the order of the others
+  void compact();
+
+  size_t victimIn(const List &list, const std::function<bool(size_t)> &evictable) const;
+
+  void coldestIn(const List &list, size_t n, std::vector<size_t> &out) const;
+
+public:
+  explicit TwoQueuePolicy(size_t num_frames);
+
+  void insert(size_t pos, size_t key) override;
+
+  void touch(size_t pos) override;
+
+  void erase(size_t pos) override;
+
+  void demote(size_t pos) override;
+
+  size_t victim(const std::function<bool(size_t)> &evictable) override;
+
+  void coldest(size_t n, std::vector<size_t> &out) const override;
+};
+} // namespace db
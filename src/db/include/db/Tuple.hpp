@@ -1,6 +1,7 @@
 #pragma once
 
 #include <db/types.hpp>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -12,7 +13,13 @@ class Tuple {
 
 public:
   Tuple(const std::vector<field_t> &fields);
+  Tuple(std::vector<field_t> &&fields);
+  /**
+   * @brief Get the type of a field
+   * @throws std::logic_error if the field is NULL
+   */
   type_t field_type(size_t i) const;
+  bool is_null(size_t i) const;
   size_t size() const;
   const field_t &get_field(size_t i) const;
 };
@@ -21,6 +28,9 @@ class TupleDesc {
   std::vector<type_t> types;
   std::vector<size_t> offsets;
   std::unordered_map<std::string, size_t> name_to_index;
+  std::vector<bool> nullable;
+  size_t bitmap = 0;
+  bool fixed = true;
 
 public:
   TupleDesc() = default;
@@ -29,15 +39,18 @@ public:
    * @details Construct a new TupleDesc object with the provided types and names
    * @param names the names of the fields
    * @param types the types of the fields
+   * @param nullable which fields may be NULL, none if empty
    * @throws std::logic_error if types and names have different lengths
+   * @throws std::logic_error if nullable is not empty and has a different length
    * @throws std::logic_error if names are not unique
    */
-  TupleDesc(const std::vector<type_t> &types, const std::vector<std::string> &names);
+  TupleDesc(const std::vector<type_t> &types, const std::vector<std::string> &names,
+            const std::vector<bool> &nullable = {});
 
   /**
    * @brief Check if the provided Tuple is compatible with this TupleDesc
    * @details A Tuple is compatible with a TupleDesc if the Tuple has the same number of fields and each field is of the
-   * same type as the corresponding field in the TupleDesc
+   * same type as the corresponding field in the TupleDesc, or is NULL and the field is nullable
    * @param tuple the Tuple to check
    * @return true if the Tuple is compatible, false otherwise
    */
@@ -51,6 +64,43 @@ public:
    */
   size_t offset_of(const size_t &index) const;
 
+  /**
+   * @brief Get the type of the field
+   * @param index the index of the field
+   * @return the type of the field
+   */
+  type_t type_of(size_t index) const;
+
+  /**
+   * @brief Check if the field may be NULL
+   * @param index the index of the field
+   * @return true if the field is nullable
+   */
+  bool is_nullable(size_t index) const;
+
+  /**
+   * @brief Get the length of the null bitmap
+   * @details A serialized Tuple starts with a bitmap of one bit per field, most significant bit first, whose bit is set
+   * for NULL fields. The bitmap is only there if a field is nullable.
+   * @return the number of bytes of the bitmap, 0 if no field is nullable
+   */
+  size_t bitmap_length() const;
+
+  /**
+   * @brief Check the bit of a field in a null bitmap
+   * @param bitmap the bitmap at the start of a serialized Tuple
+   * @param index the index of the field
+   * @return true if the field is NULL
+   */
+  static bool is_null(const uint8_t *bitmap, size_t index);
+
+  /**
+   * @brief Get the width of the field
+   * @param index the index of the field
+   * @return the number of bytes the field is serialized into
+   */
+  size_t width_of(size_t index) const;
+
   /**
    * @brief Get the index of the field
    * @details The index of the field is the position of the field in the Tuple
@@ -67,14 +117,38 @@ public:
 
   /**
    * @brief Get the length of the TupleDesc
-   * @return the number of bytes needed to serialize a Tuple with this TupleDesc
+   * @details A serialized Tuple starts with the null bitmap, if any, and its fields in order, each VARCHAR field as the
+   * offset of its value. The values of the VARCHAR fields follow, each as a 16-bit length and the characters. A NULL
+   * field is zeroed, and a NULL VARCHAR field has an empty value.
+   * @return the number of bytes needed to serialize a Tuple with this TupleDesc, without the values of VARCHAR fields
    */
   size_t length() const;
 
+  /**
+   * @brief Get the serialized length of a Tuple
+   * @param t the Tuple, which must be compatible
+   * @return the number of bytes needed to serialize the Tuple
+   */
+  size_t length(const Tuple &t) const;
+
+  /**
+   * @brief Get the length of a serialized Tuple
+   * @param data the serialized Tuple
+   * @return the number of bytes of the serialized Tuple
+   */
+  size_t length(const uint8_t *data) const;
+
+  /**
+   * @brief Check if all Tuples have the same length
+   * @return false if there is a VARCHAR field, true otherwise
+   */
+  bool is_fixed() const;
+
   /**
    * @brief Serialize a Tuple
-   * @param data the buffer to serialize the Tuple into
+   * @param data the buffer to serialize the Tuple into, of `length(t)` bytes
    * @param t the Tuple to serialize
+   * @throws std::length_error if the Tuple is longer than 65535 bytes
    */
   void serialize(uint8_t *data, const Tuple &t) const;
 
@@ -85,13 +159,132 @@ public:
    */
   Tuple deserialize(const uint8_t *data) const;
 
+  /**
+   * @brief Deserialize some fields of a Tuple
+   * @details Only the listed fields are decoded, the others are skipped without being read
+   * @param data the buffer to deserialize the Tuple from
+   * @param indices the indices of the fields to decode, in the order they appear in the result
+   * @return the Tuple of the decoded fields
+   * @throws std::out_of_range if an index is not a field
+   */
+  Tuple deserialize(const uint8_t *data, const std::vector<size_t> &indices) const;
+
   /**
    * @brief Merge two TupleDescs
-   * @details The merged TupleDesc has all the fields of the two TupleDescs
+   * @details The merged TupleDesc has all the fields of the two TupleDescs, with their nullability
    * @param td1 the first TupleDesc
    * @param td2 the second TupleDesc
    * @return the merged TupleDesc
    */
   static db::TupleDesc merge(const TupleDesc &td1, const TupleDesc &td2);
 };
+
+/**
+ * @brief A read-only view of a serialized tuple that decodes single fields on demand.
+ * @details Reading an INT or DOUBLE field, or a CHAR field as a string_view, does not allocate. The view points into the
+ * page it was read from, so it is only valid while that page stays pinned (e.g. while the iterator that returned it
+ * stays on the page) and the slot is not modified. The fields are either contiguous (a row) or spread over the columns
+ * of a PAX page.
+ */
+class TupleView {
+  const TupleDesc *td;
+  const uint8_t *data;
+  /// The number of slots per column of a PAX page, or 0 for a row
+  size_t capacity = 0;
+  size_t slot = 0;
+
+  const uint8_t *field(size_t i) const;
+
+public:
+  /**
+   * @brief View a tuple serialized as a row.
+   * @param data The start of the row.
+   */
+  TupleView(const TupleDesc &td, const uint8_t *data);
+
+  /**
+   * @brief View a tuple of a PAX page, in which column `i` of slot `s` is at
+   * `columns + capacity * td.offset_of(i) + s * td.width_of(i)`.
+   */
+  TupleView(const TupleDesc &td, const uint8_t *columns, size_t capacity, size_t slot);
+
+  size_t size() const;
+
+  type_t field_type(size_t i) const;
+
+  /**
+   * @brief Check if a field is NULL.
+   * @details The bitmap is not read for fields that are not nullable. The typed getters read a NULL field as 0 or as an
+   * empty string.
+   */
+  bool is_null(size_t i) const;
+
+  /**
+   * @brief Decode an INT field.
+   * @throws std::logic_error if the field is not an INT.
+   */
+  int get_int(size_t i) const;
+
+  /**
+   * @brief Decode a DOUBLE field.
+   * @throws std::logic_error if the field is not a DOUBLE.
+   */
+  double get_double(size_t i) const;
+
+  /**
+   * @brief Decode an INT64 field.
+   * @throws std::logic_error if the field is not an INT64.
+   */
+  int64_t get_int64(size_t i) const;
+
+  /**
+   * @brief Decode a TIMESTAMP field.
+   * @throws std::logic_error if the field is not a TIMESTAMP.
+   */
+  timestamp_t get_timestamp(size_t i) const;
+
+  /**
+   * @brief Decode a DECIMAL field.
+   * @throws std::logic_error if the field is not a DECIMAL.
+   */
+  decimal_t get_decimal(size_t i) const;
+
+  /**
+   * @brief Return a CHAR or VARCHAR field without copying it.
+   * @throws std::logic_error if the field is not a CHAR or VARCHAR.
+   */
+  std::string_view get_char(size_t i) const;
+
+  /**
+   * @brief Decode any field, which copies CHAR fields into a string_t.
+   * @return The field, or null_t if it is NULL.
+   */
+  field_t get_field(size_t i) const;
+
+  /**
+   * @brief Decode all fields.
+   * @return The same Tuple as TupleDesc::deserialize.
+   */
+  Tuple materialize() const;
+
+  /**
+   * @brief Decode some fields.
+   * @return The same Tuple as TupleDesc::deserialize with the same indices.
+   */
+  Tuple materialize(const std::vector<size_t> &indices) const;
+
+  /**
+   * @brief Copy the serialized fields into a row, without decoding them.
+   * @param out The buffer of `td.length(data)` bytes, filled as TupleDesc::serialize would.
+   */
+  void serialize(uint8_t *out) const;
+
+  /**
+   * @brief Copy some serialized fields into a row, without decoding them.
+   * @param out The buffer, filled as TupleDesc::serialize would fill it with a tuple of the listed fields, whose
+   * nullability is kept. The row has a null bitmap if one of the listed fields is nullable.
+   * @param indices The indices of the fields, in the order they appear in the row.
+   */
+  void serialize(uint8_t *out, const std::vector<size_t> &indices) const;
+};
 } // namespace db
@@ -1,25 +1,170 @@
 #pragma once
 
 #include <array>
+#include <compare>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
-#include <cstdint>
 
 namespace db {
 constexpr size_t INT_SIZE = sizeof(int);
 constexpr size_t DOUBLE_SIZE = sizeof(double);
 constexpr size_t CHAR_SIZE = 64;
+/// The bytes of a VARCHAR field in the fixed part of a row: the offset of its length-prefixed value from the row start
+constexpr size_t VARCHAR_SIZE = sizeof(uint16_t);
+constexpr size_t INT64_SIZE = sizeof(int64_t);
+constexpr size_t TIMESTAMP_SIZE = sizeof(int64_t);
+constexpr size_t DECIMAL_SIZE = sizeof(int64_t);
+
+/// The units of a decimal_t in 1, decimals have 4 fractional digits
+constexpr int64_t DECIMAL_SCALE = 10'000;
+
+/**
+ * @details CHAR fields hold at most CHAR_SIZE characters and always take CHAR_SIZE bytes, VARCHAR fields take what they
+ * hold. INT64, TIMESTAMP and DECIMAL fields are all stored as a 64-bit integer.
+ */
+enum class type_t { INT, CHAR, DOUBLE, VARCHAR, INT64, TIMESTAMP, DECIMAL };
+
+/// A point in time, in microseconds since the Unix epoch (UTC)
+struct timestamp_t {
+  int64_t micros = 0;
+
+  auto operator<=>(const timestamp_t &) const = default;
+};
+
+/// A fixed-point number with 4 fractional digits, in units of 1 / DECIMAL_SCALE
+struct decimal_t {
+  int64_t units = 0;
+
+  auto operator<=>(const decimal_t &) const = default;
+};
+
+/// The value of a NULL field, which compares unknown to any value
+using null_t = std::monostate;
+
+/**
+ * @brief The value of a CHAR or VARCHAR field.
+ * @details Up to CHAR_SIZE characters are stored inline, so a CHAR value never allocates, and copying a tuple copies its
+ * strings in place. Longer VARCHAR values are kept on the heap.
+ */
+class string_t {
+  union {
+    std::array<char, CHAR_SIZE> chars;
+    char *heap;
+  };
+  size_t length = 0;
+
+  bool inlined() const { return length <= CHAR_SIZE; }
+
+  void assign(const char *data, size_t size) {
+    if (size > CHAR_SIZE) {
+      heap = new char[size];
+    }
+    length = size;
+    std::memcpy(inlined() ? chars.data() : heap, data, size);
+  }
+
+  /// Takes the characters of `other`, which is left empty
+  void steal(string_t &other) noexcept {
+    length = other.length;
+    if (inlined()) {
+      std::memcpy(chars.data(), other.chars.data(), length);
+    } else {
+      heap = other.heap;
+    }
+    other.length = 0;
+  }
+
+  void release() noexcept {
+    if (!inlined()) {
+      delete[] heap;
+    }
+    length = 0;
+  }
+
+public:
+  string_t() noexcept : chars() {}
+
+  string_t(const char *data, size_t size) { assign(data, size); }
+
+  string_t(std::string_view s) : string_t(s.data(), s.size()) {}
 
-enum class type_t { INT, CHAR, DOUBLE };
+  string_t(const char *s) : string_t(std::string_view(s)) {}
 
-using field_t = std::variant<int, double, std::string>;
+  string_t(const std::string &s) : string_t(s.data(), s.size()) {}
 
+  string_t(const string_t &other) : string_t(other.data(), other.size()) {}
+
+  string_t(string_t &&other) noexcept { steal(other); }
+
+  string_t &operator=(const string_t &other) {
+    if (this != &other) {
+      string_t copy(other);
+      release();
+      steal(copy);
+    }
+    return *this;
+  }
+
+  string_t &operator=(string_t &&other) noexcept {
+    if (this != &other) {
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~string_t() { release(); }
+
+  /// The characters, which are not NUL-terminated
+  const char *data() const { return inlined() ? chars.data() : heap; }
+
+  size_t size() const { return length; }
+
+  bool empty() const { return length == 0; }
+
+  std::string_view view() const { return {data(), length}; }
+
+  operator std::string_view() const { return view(); }
+
+  friend bool operator==(const string_t &a, const string_t &b) { return a.view() == b.view(); }
+
+  friend bool operator==(const string_t &a, std::string_view b) { return a.view() == b; }
+
+  friend bool operator==(const string_t &a, const std::string &b) { return a.view() == b; }
+
+  friend bool operator==(const string_t &a, const char *b) { return a.view() == b; }
+
+  friend std::strong_ordering operator<=>(const string_t &a, const string_t &b) { return a.view() <=> b.view(); }
+};
+
+using field_t = std::variant<int, double, string_t, int64_t, timestamp_t, decimal_t, null_t>;
+
+/// The compact id the Database assigns to the name of a file, see Database::getFileId
+using file_id_t = uint32_t;
+
+/**
+ * @brief Identifies a page by the id of its file and its page number.
+ * @note A trivially copyable 16-byte key, so hashing and comparing it never touches the file name.
+ */
 struct PageId {
-  std::string file;
-  size_t page;
+  file_id_t file = 0;
+  size_t page = 0;
 
 public:
+  PageId() = default;
+
+  PageId(file_id_t file, size_t page) : file(file), page(page) {}
+
+  /**
+   * @brief Construct the id of a page of the file with the specified name.
+   * @details Looks up (or assigns) the id of the name in the catalog of the Database.
+   */
+  PageId(const std::string &name, size_t page);
+
   bool operator==(const PageId &) const = default;
 };
 
@@ -30,6 +175,13 @@ using Page = std::array<uint8_t, DEFAULT_PAGE_SIZE>;
 
 template <> struct std::hash<const db::PageId> {
   std::size_t operator()(const db::PageId &r) const {
-    return std::hash<std::string>()(r.file) ^ std::hash<size_t>()(r.page);
+    // The finalizer of MurmurHash3 on the combined key, so consecutive pages spread over all buckets and shards
+    uint64_t x = (static_cast<uint64_t>(r.file) << 40) ^ r.page;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
   }
 };
@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <set>
+#include <thread>
 
 TEST(BufferPoolTest, getPage) {
   db::Database &db = db::getDatabase();
@@ -10,6 +13,8 @@ TEST(BufferPoolTest, getPage) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  // Retain the page ids of the reads and writes, by default they are only counted
+  db.get(name).setTraceCapacity(1024);
   std::array<db::Page *, db::DEFAULT_NUM_PAGES> pages{};
   for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
     pages[i] = &bufferPool.getPage({name, i});
@@ -37,6 +42,7 @@ TEST(BufferPoolTest, getPageMultipleFiles) {
   for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
     auto file = std::make_unique<db::DbFile>(std::to_string(i), td);
     files[i] = file.get();
+    file->setTraceCapacity(1024);
     db.add(std::move(file));
   }
   std::array<db::Page *, db::DEFAULT_NUM_PAGES> pages{};
@@ -65,6 +71,7 @@ TEST(BufferPoolTest, eviction) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(1024);
   std::array<db::Page *, db::DEFAULT_NUM_PAGES> pages{};
   for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
     pages[i] = &bufferPool.getPage({name, i});
@@ -95,6 +102,7 @@ TEST(BufferPoolTest, markDirty) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(1024);
   std::array<db::Page *, db::DEFAULT_NUM_PAGES> pages{};
   for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
     pages[i] = &bufferPool.getPage({name, i});
@@ -128,6 +136,7 @@ TEST(BufferPoolTest, flushPage) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(1024);
   db::PageId pid{name, 0};
   bufferPool.getPage(pid);
   bufferPool.markDirty(pid);
@@ -154,6 +163,7 @@ TEST(BufferPoolTest, discardPage) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(1024);
   db::PageId pid{name, 0};
   bufferPool.getPage(pid);
   bufferPool.markDirty(pid);
@@ -207,6 +217,7 @@ TEST(BufferPoolTest, LRU) {
   std::string name{"file"};
   db::TupleDesc td;
   db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(1024);
   std::array<db::Page *, db::DEFAULT_NUM_PAGES> pages{};
   // fill the buffer pool with pages [0, DEFAULT_NUM_PAGES)
   for (size_t i = 0; i < db::DEFAULT_NUM_PAGES; i++) {
@@ -249,3 +260,391 @@ TEST(BufferPoolTest, LRU) {
     EXPECT_EQ(writes[i], size + i);
   }
 }
+
+TEST(BufferPoolTest, configureCapacity) {
+  constexpr size_t capacity = 8;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  EXPECT_EQ(bufferPool.getNumPages(), capacity);
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  std::array<db::Page *, capacity> pages{};
+  for (size_t i = 0; i < capacity; i++) {
+    pages[i] = &bufferPool.getPage({name, i});
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(pages[i]) % db::DEFAULT_PAGE_SIZE, 0);
+  }
+  for (size_t i = 0; i < capacity; i++) {
+    EXPECT_EQ(pages[i], &bufferPool.getPage({name, i}));
+  }
+  bufferPool.getPage({name, capacity});
+  EXPECT_FALSE(bufferPool.contains({name, 0}));
+  EXPECT_TRUE(bufferPool.contains({name, capacity}));
+  EXPECT_EQ(db.get(name).getReads().size(), capacity + 1);
+
+  db.configureBufferPool(db::BufferPoolConfig::fromBytes(3 * db::DEFAULT_PAGE_SIZE + 1));
+  EXPECT_EQ(db.getBufferPool().getNumPages(), 3);
+  EXPECT_ANY_THROW(db::BufferPoolConfig::fromBytes(db::DEFAULT_PAGE_SIZE - 1));
+}
+
+TEST(BufferPoolTest, configureFlushesDirtyPages) {
+  db::Database &db = db::getDatabase();
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  db::PageId pid{name, 0};
+  bufferPool.getPage(pid);
+  bufferPool.markDirty(pid);
+  db.configureBufferPool({db::DEFAULT_NUM_PAGES, true});
+  EXPECT_FALSE(db.getBufferPool().contains(pid));
+  EXPECT_EQ(db.get(name).getWrites().size(), 1);
+}
+
+TEST(BufferPoolTest, shardedHits) {
+  constexpr size_t shards = 4;
+  constexpr size_t capacity = 64;
+  constexpr size_t working_set = capacity / shards / 2;
+  constexpr size_t threads = 8;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity, .num_shards = shards});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  EXPECT_EQ(bufferPool.getNumShards(), shards);
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  std::array<db::Page *, working_set> pages{};
+  for (size_t i = 0; i < working_set; i++) {
+    pages[i] = &bufferPool.getPage({name, i});
+  }
+
+  // A working set that fits in any single shard stays resident, so concurrent lookups are all hits
+  std::vector<std::thread> workers;
+  std::atomic<size_t> mismatches{0};
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      for (size_t i = 0; i < 10000; i++) {
+        size_t page = (i + t) % working_set;
+        if (&bufferPool.getPage({name, page}) != pages[page]) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(mismatches, 0);
+  EXPECT_EQ(db.get(name).getReads().size(), working_set);
+}
+
+TEST(BufferPoolTest, shardIndependentOfSlots) {
+  // The pages of one shard must not share the low hash bits, which pick their home slot in the shard's page table
+  constexpr size_t shards = 64;
+  std::set<size_t> homes;
+  for (size_t page = 0; page < 64 * shards; page++) {
+    db::PageId pid{1, page};
+    if (db::BufferPool::shardIndex(pid, shards) == 0) {
+      homes.insert(std::hash<const db::PageId>()(pid) % shards);
+    }
+  }
+  EXPECT_GT(homes.size(), shards / 2);
+}
+
+TEST(BufferPoolTest, shardedEvictions) {
+  constexpr size_t capacity = 32;
+  constexpr size_t threads = 8;
+  constexpr size_t pages_per_thread = 64;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity, .num_shards = 4});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  db::TupleDesc td;
+  for (size_t t = 0; t < threads; t++) {
+    db.add(std::make_unique<db::DbFile>("file" + std::to_string(t), td));
+  }
+
+  // Every thread streams over a file larger than the pool, forcing evictions in all shards
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      std::string name = "file" + std::to_string(t);
+      for (size_t round = 0; round < 4; round++) {
+        for (size_t i = 0; i < pages_per_thread; i++) {
+          bufferPool.getPage({name, i});
+        }
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  size_t resident = 0;
+  for (size_t t = 0; t < threads; t++) {
+    std::string name = "file" + std::to_string(t);
+    EXPECT_GE(db.get(name).getReads().size(), pages_per_thread);
+    EXPECT_EQ(db.get(name).getWrites().size(), 0);
+    for (size_t i = 0; i < pages_per_thread; i++) {
+      resident += bufferPool.contains({name, i});
+    }
+  }
+  EXPECT_EQ(resident, capacity);
+}
+
+TEST(BufferPoolTest, pinnedPagesAreNotEvicted) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  db::PageGuard oldest = bufferPool.fetchPage({name, 0}, true);
+  EXPECT_TRUE(bufferPool.isDirty({name, 0}));
+  for (size_t i = 1; i < capacity; i++) {
+    bufferPool.getPage({name, i});
+  }
+
+  // page 0 is the least recently used page but it is pinned, so page 1 is evicted instead
+  bufferPool.getPage({name, capacity});
+  EXPECT_TRUE(bufferPool.contains({name, 0}));
+  EXPECT_FALSE(bufferPool.contains({name, 1}));
+  EXPECT_ANY_THROW(bufferPool.discardPage({name, 0}));
+
+  {
+    db::PageGuard copy = oldest;
+    oldest.release();
+    EXPECT_FALSE(oldest);
+    EXPECT_EQ(copy.getPageId().page, 0);
+    bufferPool.getPage({name, capacity + 1});
+    EXPECT_TRUE(bufferPool.contains({name, 0}));
+  }
+
+  // once every guard is released the page can be evicted again
+  bufferPool.getPage({name, capacity + 2});
+  EXPECT_FALSE(bufferPool.contains({name, 0}));
+  EXPECT_EQ(db.get(name).getWrites().size(), 1);
+}
+
+TEST(BufferPoolTest, allPagesPinned) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  std::vector<db::PageGuard> guards;
+  for (size_t i = 0; i < capacity; i++) {
+    guards.push_back(bufferPool.fetchPage({name, i}));
+  }
+  EXPECT_ANY_THROW(bufferPool.getPage({name, capacity}));
+  guards.back().markDirty();
+  EXPECT_TRUE(bufferPool.isDirty({name, capacity - 1}));
+  guards.pop_back();
+  EXPECT_NO_THROW(bufferPool.getPage({name, capacity}));
+  EXPECT_FALSE(bufferPool.contains({name, capacity - 1}));
+}
+
+TEST(BufferPoolTest, failedReads) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  // The offset of the page is negative, so reading it fails
+  constexpr size_t bad = size_t{1} << 51;
+  for (size_t i = 0; i < 2 * capacity; i++) {
+    EXPECT_THROW(bufferPool.fetchPage({name, bad + i}), std::runtime_error);
+    EXPECT_FALSE(bufferPool.contains({name, bad + i}));
+  }
+  // The frames of the failed reads are still usable
+  std::vector<db::PageGuard> guards;
+  for (size_t i = 0; i < capacity; i++) {
+    guards.push_back(bufferPool.fetchPage({name, i}));
+  }
+  EXPECT_EQ(guards.size(), capacity);
+}
+
+TEST(BufferPoolTest, backgroundWriter) {
+  constexpr size_t capacity = 16;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool(
+      {.num_pages = capacity, .writer_clean_fraction = 0.5, .writer_interval = std::chrono::milliseconds(100)});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  for (size_t i = 0; i < capacity; i++) {
+    bufferPool.getPage({name, i});
+    bufferPool.markDirty({name, i});
+  }
+  // The first round starts after an interval, once every page is dirty
+  for (int i = 0; i < 5000 && bufferPool.getWriterStats().pages < capacity / 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Only the cold half is written back, in a single call since the pages are adjacent
+  for (size_t i = 0; i < capacity; i++) {
+    EXPECT_EQ(bufferPool.isDirty({name, i}), i >= capacity / 2);
+  }
+  db::WriterStats stats = bufferPool.getWriterStats();
+  EXPECT_EQ(stats.pages, capacity / 2);
+  EXPECT_EQ(stats.writes, 1);
+  EXPECT_GT(stats.pages_per_second, 0);
+
+  // Evicting the clean pages needs no foreground write
+  size_t writes = db.get(name).getWrites().size();
+  for (size_t i = capacity; i < capacity + capacity / 2; i++) {
+    bufferPool.getPage({name, i});
+  }
+  EXPECT_EQ(db.get(name).getWrites().size(), writes);
+}
+
+TEST(BufferPoolTest, directIo) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity, .direct_io = true});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  std::remove(name.c_str());
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  // Filesystems without O_DIRECT support keep using the page cache
+  bool direct = db.get(name).isDirectIo();
+  for (size_t i = 0; i < 2 * capacity; i++) {
+    bufferPool.getPage({name, i}).fill(static_cast<uint8_t>(i + 1));
+    bufferPool.markDirty({name, i});
+  }
+  bufferPool.flushFile(name);
+  for (size_t i = 0; i < 2 * capacity; i++) {
+    EXPECT_EQ(bufferPool.getPage({name, i})[0], i + 1);
+  }
+
+  // A page that is not a frame of the pool need not be aligned
+  std::vector<uint8_t> buffer(db::DEFAULT_PAGE_SIZE + 1);
+  auto &page = *reinterpret_cast<db::Page *>(buffer.data() + 1);
+  db.get(name).readPage(page, 1);
+  EXPECT_EQ(page[0], 2);
+  page.fill(9);
+  db.get(name).writePage(page, 1);
+  ASSERT_FALSE(bufferPool.contains({name, 1}));
+  EXPECT_EQ(bufferPool.getPage({name, 1})[0], 9);
+
+  db.configureBufferPool({.num_pages = capacity});
+  EXPECT_FALSE(db.get(name).isDirectIo());
+  db.configureBufferPool({.num_pages = capacity, .direct_io = true});
+  EXPECT_EQ(db.get(name).isDirectIo(), direct);
+}
+
+TEST(BufferPoolTest, ioStats) {
+  constexpr size_t capacity = 4;
+  constexpr size_t pages = 10;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  db::DbFile &file = db.get(name);
+  file.setTraceCapacity(capacity);
+  for (size_t i = 0; i < pages; i++) {
+    bufferPool.getPage({name, i});
+    bufferPool.markDirty({name, i});
+  }
+  bufferPool.flushFile(name);
+
+  // Every access is counted but the trace only retains the last ones
+  const db::IoTrace &reads = file.getReads();
+  EXPECT_EQ(reads.size(), pages);
+  EXPECT_EQ(reads[pages - 1], pages - 1);
+  EXPECT_THROW(reads[pages - capacity - 1], std::out_of_range);
+  EXPECT_EQ(reads.retained(), (std::vector<size_t>{6, 7, 8, 9}));
+
+  db::IoStats stats = file.getIoStats();
+  EXPECT_EQ(stats.pages_read, pages);
+  EXPECT_EQ(stats.bytes_read, pages * db::DEFAULT_PAGE_SIZE);
+  EXPECT_EQ(stats.pages_written, pages);
+  EXPECT_EQ(stats.bytes_written, pages * db::DEFAULT_PAGE_SIZE);
+  EXPECT_EQ(stats.read_latency.count(), pages);
+  // One eviction per page after the first `capacity`, then a single batch for the rest
+  EXPECT_EQ(stats.write_latency.count(), pages - capacity + 1);
+  EXPECT_LE(stats.read_latency.quantile(0.5), stats.read_latency.quantile(1));
+
+  // Without a trace the accesses are still counted
+  file.setTraceCapacity(0);
+  bufferPool.getPage({name, 0});
+  EXPECT_EQ(file.getReads().size(), 1);
+  EXPECT_THROW(file.getReads()[0], std::out_of_range);
+}
+
+TEST(BufferPoolTest, cacheStats) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string hot{"hot"};
+  std::string cold{"cold"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(hot, td));
+  db.add(std::make_unique<db::DbFile>(cold, td));
+
+  // Two hot pages stay resident while a cold scan cycles through the other two frames
+  bufferPool.getPage({hot, 0});
+  bufferPool.getPage({hot, 1});
+  for (size_t i = 0; i < 6; i++) {
+    bufferPool.getPage({hot, i % 2});
+    bufferPool.getPage({cold, i});
+    bufferPool.markDirty({cold, i});
+  }
+  bufferPool.markDirty({hot, 0});
+  bufferPool.flushPage({hot, 0});
+  bufferPool.flushPage({hot, 0});
+  bufferPool.flushFile(cold);
+
+  db::BufferPoolStats stats = bufferPool.getStats();
+  const db::BufferPoolCounters &h = stats.files.at(hot);
+  EXPECT_EQ(h.hits, 6);
+  EXPECT_EQ(h.misses, 2);
+  EXPECT_EQ(h.evictions, 0);
+  EXPECT_EQ(h.flushes, 1);
+  EXPECT_DOUBLE_EQ(h.hitRatio(), 0.75);
+
+  const db::BufferPoolCounters &c = stats.files.at(cold);
+  EXPECT_EQ(c.hits, 0);
+  EXPECT_EQ(c.misses, 6);
+  EXPECT_EQ(c.evictions, 4);
+  EXPECT_EQ(c.dirty_evictions, 4);
+  EXPECT_EQ(c.flushes, 2);
+  EXPECT_EQ(c.miss_latency.count(), 6);
+  EXPECT_GT(c.miss_latency.mean().count(), 0);
+  EXPECT_LE(c.miss_latency.quantile(0.5), c.miss_latency.quantile(0.99));
+
+  EXPECT_EQ(stats.total.hits, 6);
+  EXPECT_EQ(stats.total.misses, 8);
+  EXPECT_EQ(stats.total.evictions, 4);
+  EXPECT_EQ(stats.total.flushes, 3);
+
+  // A reset returns the same counters and starts over
+  EXPECT_EQ(bufferPool.resetStats().total.misses, 8);
+  EXPECT_TRUE(bufferPool.getStats().files.empty());
+  bufferPool.getPage({hot, 0});
+  stats = bufferPool.getStats();
+  EXPECT_EQ(stats.total.hits, 1);
+  EXPECT_EQ(stats.total.misses, 0);
+  EXPECT_EQ(stats.files.size(), 1);
+}
@@ -2,6 +2,7 @@
 
 #include <db/Database.hpp>
 #include <db/DbFile.hpp>
+#include <set>
 
 TEST(DatabaseTest, AddDbFile) {
   db::Database &db = db::getDatabase();
@@ -116,3 +117,52 @@ TEST(DatabaseTest, MultipleOperations) {
   db.add(std::move(file));
   EXPECT_EQ(expected, &db.get(name2));
 }
+
+TEST(DatabaseTest, FileIds) {
+  static_assert(std::is_trivially_copyable_v<db::PageId>);
+  static_assert(sizeof(db::PageId) == 16);
+  db::Database &db = db::getDatabase();
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>("ids1", td));
+  db.add(std::make_unique<db::DbFile>("ids2", td));
+  db::file_id_t id1 = db.get("ids1").getId();
+  db::file_id_t id2 = db.get("ids2").getId();
+  EXPECT_NE(id1, id2);
+  EXPECT_EQ(&db.get(id1), &db.get("ids1"));
+  EXPECT_EQ(db::PageId("ids2", 3), db::PageId(id2, 3));
+
+  // A removed file cannot be looked up by its id, but its name keeps the id
+  db.remove("ids1");
+  EXPECT_THROW(db.get(id1), std::out_of_range);
+  db.add(std::make_unique<db::DbFile>("ids1", td));
+  EXPECT_EQ(db.get("ids1").getId(), id1);
+
+  // Consecutive pages of a file do not collide in the low bits used for buckets and shards
+  std::hash<const db::PageId> hash;
+  std::set<size_t> buckets;
+  for (size_t page = 0; page < 64; page++) {
+    buckets.insert(hash({id1, page}) % 64);
+  }
+  EXPECT_GT(buckets.size(), 32);
+}
+
+TEST(DatabaseTest, RemoveDiscardsPages) {
+  db::Database &db = db::getDatabase();
+  db::TupleDesc td;
+  const char *name = "discard";
+  std::remove(name);
+  db.add(std::make_unique<db::DbFile>(name, td));
+  {
+    db::PageGuard page = db.getBufferPool().fetchPage({name, 0}, true);
+    (*page)[0] = 42;
+  }
+  db.remove(name);
+  EXPECT_FALSE(db.getBufferPool().contains({name, 0}));
+
+  // A new file under the same name and id reads its own pages
+  std::remove(name);
+  db.add(std::make_unique<db::DbFile>(name, td));
+  EXPECT_EQ((*db.getBufferPool().fetchPage({name, 0}))[0], 0);
+  db.remove(name);
+  std::remove(name);
+}
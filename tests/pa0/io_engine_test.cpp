@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <db/Database.hpp>
+#include <db/DbFile.hpp>
+#include <db/IoEngine.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+void roundTrip(db::IoEngineType type) {
+  constexpr size_t pages = 100;
+  const char *name = "io_engine_test.dat";
+  std::remove(name);
+  int fd = open(name, O_RDWR | O_CREAT, 0644);
+  ASSERT_NE(fd, -1);
+  auto engine = db::IoEngine::create(type, 8);
+
+  // More requests than the queue depth, adjacent ones first and then scattered ones
+  std::vector<db::Page> out(pages);
+  std::vector<db::IoRequest> writes;
+  for (size_t i = 0; i < pages; i++) {
+    size_t page = i < pages / 2 ? i : pages + 3 * i;
+    out[i].fill(static_cast<uint8_t>(i));
+    writes.push_back({db::IoRequest::Op::WRITE, fd, out[i].data(), db::DEFAULT_PAGE_SIZE,
+                      static_cast<off_t>(page * db::DEFAULT_PAGE_SIZE)});
+  }
+  engine->submit(writes);
+
+  std::vector<db::Page> in(pages);
+  std::vector<db::IoRequest> reads;
+  for (size_t i = pages; i-- > 0;) {
+    db::IoRequest read = writes[i];
+    read.op = db::IoRequest::Op::READ;
+    read.data = in[i].data();
+    reads.push_back(read);
+  }
+  engine->submit(reads);
+  EXPECT_EQ(in, out);
+
+  // Reading past the end of the file leaves the buffer as it was
+  db::Page past{};
+  engine->submit({{db::IoRequest::Op::READ, fd, past.data(), db::DEFAULT_PAGE_SIZE, 1 << 30}});
+  EXPECT_EQ(past, db::Page{});
+
+  // A merged read that ends past the end of the file fills what the file has
+  constexpr size_t half = db::DEFAULT_PAGE_SIZE / 2;
+  ASSERT_EQ(ftruncate(fd, (pages / 2 - 1) * db::DEFAULT_PAGE_SIZE + half), 0);
+  std::vector<db::Page> tail(2);
+  tail[0].fill(0xff);
+  tail[1].fill(0xff);
+  engine->submit({{db::IoRequest::Op::READ, fd, tail[0].data(), db::DEFAULT_PAGE_SIZE,
+                   static_cast<off_t>((pages / 2 - 2) * db::DEFAULT_PAGE_SIZE)},
+                  {db::IoRequest::Op::READ, fd, tail[1].data(), db::DEFAULT_PAGE_SIZE,
+                   static_cast<off_t>((pages / 2 - 1) * db::DEFAULT_PAGE_SIZE)}});
+  EXPECT_EQ(tail[0], out[pages / 2 - 2]);
+  EXPECT_EQ(tail[1][half - 1], pages / 2 - 1);
+  EXPECT_EQ(tail[1][half], 0xff);
+  close(fd);
+  std::remove(name);
+}
+} // namespace
+
+TEST(IoEngineTest, Posix) { roundTrip(db::IoEngineType::POSIX); }
+
+TEST(IoEngineTest, IoUring) {
+  // Falls back to the POSIX engine if io_uring is not available
+  roundTrip(db::IoEngineType::IO_URING);
+}
+
+TEST(IoEngineTest, BatchedEvictionWrites) {
+  constexpr size_t capacity = 8;
+  constexpr size_t batch = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool(
+      {.num_pages = capacity, .io_engine = db::IoEngineType::IO_URING, .eviction_write_batch = batch});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  std::remove(name.c_str());
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  db.get(name).setTraceCapacity(capacity);
+  for (size_t i = 0; i < capacity; i++) {
+    bufferPool.getPage({name, i}).fill(static_cast<uint8_t>(i + 1));
+    bufferPool.markDirty({name, i});
+  }
+
+  // The first eviction writes the victim along with the next dirty pages in line
+  bufferPool.getPage({name, capacity});
+  EXPECT_EQ(db.get(name).getWrites().retained(), (std::vector<size_t>{0, 1, 2, 3}));
+  for (size_t i = 1; i < batch; i++) {
+    bufferPool.getPage({name, capacity + i});
+  }
+  EXPECT_EQ(db.get(name).getWrites().size(), batch);
+
+  for (size_t i = 0; i < batch; i++) {
+    EXPECT_EQ(bufferPool.getPage({name, i})[0], i + 1);
+  }
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <db/PageTable.hpp>
+#include <random>
+#include <unordered_map>
+
+TEST(PageTableTest, InsertFindErase) {
+  db::PageTable table(4);
+  table.insert({1, 7}, 0);
+  table.insert({2, 7}, 1);
+  EXPECT_EQ(table.find({1, 7}), 0);
+  EXPECT_EQ(table.at({2, 7}), 1);
+  EXPECT_EQ(table.find({1, 8}), db::PageTable::npos);
+  EXPECT_THROW(table.at({3, 7}), std::out_of_range);
+
+  table.insert({1, 7}, 2);
+  EXPECT_EQ(table.find({1, 7}), 2);
+  EXPECT_EQ(table.size(), 2);
+  EXPECT_TRUE(table.erase({1, 7}));
+  EXPECT_FALSE(table.erase({1, 7}));
+  EXPECT_FALSE(table.contains({1, 7}));
+  EXPECT_EQ(table.size(), 1);
+}
+
+TEST(PageTableTest, MatchesUnorderedMap) {
+  // Random churn at full capacity, so that erasures shift entries of long probe sequences
+  constexpr size_t capacity = 64;
+  db::PageTable table(capacity);
+  std::unordered_map<const db::PageId, size_t> expected;
+  std::mt19937_64 rng(7);
+  for (size_t i = 0; i < 100000; i++) {
+    db::PageId pid{static_cast<db::file_id_t>(rng() % 3), rng() % 256};
+    if (expected.contains(pid)) {
+      EXPECT_TRUE(table.erase(pid));
+      expected.erase(pid);
+    } else if (expected.size() < capacity) {
+      table.insert(pid, i % capacity);
+      expected[pid] = i % capacity;
+    }
+    ASSERT_EQ(table.size(), expected.size());
+  }
+  for (size_t file = 0; file < 3; file++) {
+    for (size_t page = 0; page < 256; page++) {
+      db::PageId pid{static_cast<db::file_id_t>(file), page};
+      auto it = expected.find(pid);
+      EXPECT_EQ(table.find(pid), it == expected.end() ? db::PageTable::npos : it->second);
+    }
+  }
+}
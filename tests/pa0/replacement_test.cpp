@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <db/Database.hpp>
+#include <db/ReplacementPolicy.hpp>
+#include <list>
+#include <random>
+
+namespace {
+bool any(size_t) { return true; }
+
+/// The textbook 2Q with node-based queues, to check the victims of TwoQueuePolicy against
+class TwoQueueModel {
+  size_t kin;
+  size_t kout;
+  std::vector<size_t> key_of;
+  std::list<size_t> a1in;
+  std::list<size_t> am;
+  std::list<size_t> a1out;
+
+public:
+  explicit TwoQueueModel(size_t frames)
+      : kin(std::max<size_t>(1, frames / 4)), kout(std::max<size_t>(1, frames / 2)), key_of(frames) {}
+
+  void insert(size_t pos, size_t key) {
+    key_of[pos] = key;
+    auto it = std::find(a1out.begin(), a1out.end(), key);
+    if (it != a1out.end()) {
+      a1out.erase(it);
+      am.push_front(pos);
+    } else {
+      a1in.push_front(pos);
+    }
+  }
+
+  void touch(size_t pos) {
+    a1in.remove(pos);
+    am.remove(pos);
+    am.push_front(pos);
+  }
+
+  size_t victim() {
+    if ((a1in.size() > kin || am.empty()) && !a1in.empty()) {
+      size_t pos = a1in.back();
+      a1in.pop_back();
+      a1out.remove(key_of[pos]);
+      a1out.push_back(key_of[pos]);
+      if (a1out.size() > kout) {
+        a1out.pop_front();
+      }
+      return pos;
+    }
+    size_t pos = am.back();
+    am.pop_back();
+    return pos;
+  }
+};
+} // namespace
+
+TEST(ReplacementPolicyTest, LRU) {
+  db::LruPolicy lru(4);
+  for (size_t pos = 0; pos < 4; pos++) {
+    lru.insert(pos, pos);
+  }
+  lru.touch(0);
+  EXPECT_EQ(lru.victim(any), 1);
+  EXPECT_EQ(lru.victim([](size_t pos) { return pos != 1; }), 2);
+  lru.erase(1);
+  lru.erase(2);
+  EXPECT_EQ(lru.victim(any), 3);
+  EXPECT_EQ(lru.victim([](size_t) { return false; }), db::ReplacementPolicy::npos);
+}
+
+TEST(ReplacementPolicyTest, CLOCK) {
+  db::ClockPolicy clock(4);
+  for (size_t pos = 0; pos < 4; pos++) {
+    clock.insert(pos, pos);
+  }
+  // The first sweep clears every reference bit, then frame 0 is the first without a second chance
+  EXPECT_EQ(clock.victim(any), 0);
+  clock.erase(0);
+  clock.touch(1);
+  EXPECT_EQ(clock.victim(any), 2);
+  EXPECT_EQ(clock.victim([](size_t pos) { return pos != 3; }), 1);
+  EXPECT_EQ(clock.victim([](size_t) { return false; }), db::ReplacementPolicy::npos);
+}
+
+TEST(ReplacementPolicyTest, TwoQueueScanResistance) {
+  constexpr size_t frames = 8;
+  db::TwoQueuePolicy twoq(frames);
+  std::vector<size_t> key_of(frames);
+  auto load = [&](size_t key) {
+    size_t pos = twoq.victim(any);
+    twoq.erase(pos);
+    twoq.insert(pos, key);
+    key_of[pos] = key;
+  };
+  for (size_t pos = 0; pos < frames; pos++) {
+    twoq.insert(pos, pos);
+    key_of[pos] = pos;
+  }
+
+  // Keys 0 and 1 are evicted from A1in, then referenced again, which admits them to Am
+  load(100);
+  load(101);
+  load(0);
+  load(1);
+
+  // A long scan of keys that are referenced once never displaces them
+  for (size_t key = 1000; key < 1100; key++) {
+    load(key);
+  }
+  EXPECT_NE(std::find(key_of.begin(), key_of.end(), 0), key_of.end());
+  EXPECT_NE(std::find(key_of.begin(), key_of.end(), 1), key_of.end());
+}
+
+TEST(ReplacementPolicyTest, TwoQueueGhosts) {
+  constexpr size_t frames = 8;
+  db::TwoQueuePolicy twoq(frames);
+  std::vector<size_t> key_of(frames);
+  auto load = [&](size_t key) {
+    size_t pos = twoq.victim(any);
+    twoq.erase(pos);
+    twoq.insert(pos, key);
+    key_of[pos] = key;
+  };
+  for (size_t pos = 0; pos < frames; pos++) {
+    twoq.insert(pos, pos);
+    key_of[pos] = pos;
+  }
+
+  // Key 0 is admitted to Am from A1out, then demoted and evicted from A1in again, so A1out remembers it once more
+  load(100);
+  load(0);
+  twoq.demote(std::find(key_of.begin(), key_of.end(), 0) - key_of.begin());
+  load(200);
+  load(201);
+  load(202);
+
+  // The first time key 0 was remembered does not make A1out forget it
+  load(0);
+  for (size_t key = 1000; key < 1100; key++) {
+    load(key);
+  }
+  EXPECT_NE(std::find(key_of.begin(), key_of.end(), 0), key_of.end());
+}
+
+TEST(ReplacementPolicyTest, TwoQueueMatchesModel) {
+  // Long enough for the ghost ring to wrap around and compact many times
+  constexpr size_t frames = 16;
+  db::TwoQueuePolicy twoq(frames);
+  TwoQueueModel model(frames);
+  std::vector<size_t> key_of(frames);
+  for (size_t pos = 0; pos < frames; pos++) {
+    twoq.insert(pos, pos);
+    model.insert(pos, pos);
+    key_of[pos] = pos;
+  }
+  std::mt19937_64 rng(42);
+  for (size_t i = 0; i < 100000; i++) {
+    size_t key = rng() % 48;
+    auto resident = std::find(key_of.begin(), key_of.end(), key);
+    if (resident != key_of.end()) {
+      twoq.touch(resident - key_of.begin());
+      model.touch(resident - key_of.begin());
+      continue;
+    }
+    size_t pos = twoq.victim(any);
+    ASSERT_EQ(pos, model.victim());
+    twoq.erase(pos);
+    twoq.insert(pos, key);
+    model.insert(pos, key);
+    key_of[pos] = key;
+  }
+}
+
+TEST(ReplacementPolicyTest, BufferPoolWithClock) {
+  constexpr size_t capacity = 4;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = capacity, .policy = db::ReplacementPolicyType::CLOCK});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::string name{"file"};
+  db::TupleDesc td;
+  db.add(std::make_unique<db::DbFile>(name, td));
+  db::PageGuard pinned = bufferPool.fetchPage({name, 0});
+  for (size_t i = 1; i < 3 * capacity; i++) {
+    bufferPool.getPage({name, i});
+    EXPECT_TRUE(bufferPool.contains({name, 0}));
+  }
+  EXPECT_EQ(db.get(name).getReads().size(), 3 * capacity);
+}
@@ -1,7 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <db/Database.hpp>
+#include <db/FreeSpaceMap.hpp>
 #include <db/HeapPage.hpp>
 #include <db/HeapFile.hpp>
 #include <gtest/gtest.h>
+#include <numeric>
+#include <sys/stat.h>
+#include <thread>
 
 TEST(HeapPageTest, EmptyPage) {
   db::Page page{};
@@ -124,7 +131,7 @@ TEST(HeapPageTest, GetTuple) {
   size_t slot = hp.begin();
   const auto &t1 = hp.getTuple(slot);
   EXPECT_EQ(std::get<int>(t1.get_field(0)), 660);
-  EXPECT_EQ(std::get<std::string>(t1.get_field(1)), "Hello CS660!");
+  EXPECT_EQ(std::get<db::string_t>(t1.get_field(1)), "Hello CS660!");
   hp.next(slot);
   const auto &t2 = hp.getTuple(slot);
   EXPECT_EQ(std::get<int>(t2.get_field(0)), 65535 + 1);
@@ -138,6 +145,45 @@ TEST(HeapPageTest, GetTuple) {
   EXPECT_EQ(count, 20);
 }
 
+TEST(HeapPageTest, Slotted) {
+  db::Page page{};
+  db::TupleDesc td({db::type_t::INT, db::type_t::VARCHAR}, {"id", "name"});
+  db::HeapPage hp(page, td, db::PageLayout::SLOTTED);
+  EXPECT_EQ(hp.begin(), hp.end());
+  EXPECT_EQ(hp.freeClass(), db::FreeSpaceMap::EMPTY);
+
+  // Short records fit many more tuples than a CHAR column would
+  int count = 0;
+  while (hp.insertTuple({{count, "abc"}})) {
+    count++;
+  }
+  EXPECT_GT(count, 53 * 4);
+  EXPECT_EQ(hp.size(), count);
+  EXPECT_EQ(hp.end(), count);
+
+  // Deleted records leave holes that a longer record can use once the page is compacted
+  for (size_t slot = 0; slot < 10; slot++) {
+    hp.deleteTuple(slot);
+  }
+  EXPECT_EQ(hp.freeSlots(), 10);
+  EXPECT_FALSE(hp.insertTuple({{-1, std::string(200, 'x')}}));
+  EXPECT_TRUE(hp.insertTuple({{-1, std::string(80, 'x')}}));
+  EXPECT_FALSE(hp.empty(0));
+  EXPECT_EQ(hp.getTuple(0).get_field(1), db::field_t(std::string(80, 'x')));
+  EXPECT_EQ(hp.getView(10).get_int(0), 10);
+  EXPECT_EQ(hp.getTuple(count - 1).get_field(1), db::field_t("abc"));
+
+  size_t seen = 0;
+  for (size_t slot = hp.begin(); slot != hp.end(); hp.next(slot)) {
+    seen++;
+  }
+  EXPECT_EQ(seen, count - 9);
+
+  // Deleting the last records shrinks the directory
+  hp.deleteTuple(count - 1);
+  EXPECT_EQ(hp.end(), count - 1);
+}
+
 TEST(HeapFileTest, InsertTuple) {
   std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
   std::vector<std::string> names{"id", "name", "price"};
@@ -200,3 +246,622 @@ TEST(HeapFileTest, EmptyPage) {
     i++;
   }
 }
+
+TEST(HeapFileTest, ScanKeepsHotPages) {
+  constexpr size_t pool_pages = 16;
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({.num_pages = pool_pages, .scan_ring_pages = 4});
+  db::BufferPool &bufferPool = db.getBufferPool();
+
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  constexpr size_t tuples = capacity * 4 * pool_pages;
+  for (int i = 0; i < tuples; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+
+  const char *hot = "hotfile";
+  std::remove(hot);
+  db.add(std::make_unique<db::DbFile>(hot, td));
+  for (size_t page = 0; page < pool_pages / 2; page++) {
+    bufferPool.getPage({hot, page});
+  }
+
+  // A scan of 4x the pool only cycles through the frames of its ring
+  size_t count = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), count);
+    count++;
+  }
+  EXPECT_EQ(count, tuples);
+  for (size_t page = 0; page < pool_pages / 2; page++) {
+    EXPECT_TRUE(bufferPool.contains({hot, page}));
+  }
+
+  // Without a ring the scan flushes them
+  db.configureBufferPool({.num_pages = pool_pages, .scan_ring_pages = 0});
+  for (size_t page = 0; page < pool_pages / 2; page++) {
+    db.getBufferPool().getPage({hot, page});
+  }
+  for (auto it = file.begin(); it != file.end(); ++it) {
+  }
+  EXPECT_FALSE(db.getBufferPool().contains({hot, 0}));
+}
+
+TEST(HeapFileTest, ReadAhead) {
+  db::Database &db = db::getDatabase();
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  constexpr size_t pages = 64;
+  for (int i = 0; i < capacity * pages; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+
+  // Start from an empty pool, so that every page of the scan is either prefetched or read by the scan
+  constexpr size_t window = 8;
+  db.configureBufferPool({.read_ahead_pages = window});
+  db::BufferPool &bufferPool = db.getBufferPool();
+  size_t reads = file.getReads().size();
+
+  // Moving to the second page makes the scan sequential, which requests the next pages
+  size_t count = 0;
+  auto it = file.begin();
+  for (; count < capacity; count++) {
+    ++it;
+  }
+  EXPECT_EQ(it.page, 1);
+  for (int i = 0; i < 5000 && bufferPool.getPrefetchStats().issued < window; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (size_t page = 2; page < 2 + window; page++) {
+    EXPECT_TRUE(bufferPool.contains({name, page}));
+  }
+
+  for (; it != file.end(); ++it) {
+    EXPECT_EQ(std::get<int>((*it).get_field(0)), count);
+    count++;
+  }
+  EXPECT_EQ(count, capacity * pages);
+
+  // No page is read twice, and every prefetched page was used by the scan
+  EXPECT_EQ(file.getReads().size() - reads, pages);
+  db::PrefetchStats stats = bufferPool.getPrefetchStats();
+  EXPECT_GE(stats.hits, window);
+  EXPECT_EQ(stats.wasted, 0);
+  EXPECT_LE(stats.issued, stats.hits + stats.misses);
+}
+
+TEST(HeapFileTest, Mapped) {
+  db::Database &db = db::getDatabase();
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  constexpr size_t pages = 8;
+  for (int i = 0; i < capacity * pages; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+
+  // Write the pages to the file and start from an empty pool
+  db.configureBufferPool({});
+  ASSERT_TRUE(file.map(db::AccessPattern::SEQUENTIAL));
+  size_t reads = file.getReads().size();
+  size_t count = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)), count);
+    count++;
+  }
+  EXPECT_EQ(count, capacity * pages);
+  EXPECT_EQ(file.getReads().size(), reads);
+
+  // Writes go through the pool, and reads see the newer contents of the frames
+  auto it = file.begin();
+  EXPECT_TRUE(it.guard.isMapped());
+  file.deleteTuple(it);
+  file.insertTuple({{-1, "Hello", 3.14}});
+  count = 0;
+  for (const auto &t : file) {
+    EXPECT_NE(std::get<int>(t.get_field(0)), 0);
+    count++;
+  }
+  EXPECT_EQ(count, capacity * pages);
+  file.unmap();
+}
+
+TEST(HeapFileTest, FreeSpaceReuse) {
+  db::Database &db = db::getDatabase();
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  constexpr size_t pages = 4;
+  for (int i = 0; i < capacity * pages; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+  EXPECT_EQ(file.getNumPages(), pages);
+
+  // Empty pages 0 and 2, the next inserts fill them again instead of growing the file
+  for (size_t page : {0, 2}) {
+    for (size_t slot = 0; slot < capacity; slot++) {
+      file.deleteTuple({file, page, slot});
+    }
+  }
+  for (int i = 0; i < capacity * 2; ++i) {
+    file.insertTuple({{-1, "Hello", 3.14}});
+  }
+  EXPECT_EQ(file.getNumPages(), pages);
+  size_t count = 0;
+  for (const auto &t : file) {
+    EXPECT_EQ(std::get<int>(t.get_field(0)) == -1, count / capacity % 2 == 0);
+    count++;
+  }
+  EXPECT_EQ(count, capacity * pages);
+
+  // The map is saved when the file is closed and loaded when it is opened again, without scanning the pages
+  db.remove(name);
+  struct stat st{};
+  ASSERT_EQ(stat("heapfile.fsm", &st), 0);
+  EXPECT_EQ(st.st_size, pages);
+  db.configureBufferPool({});
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &reopened = db.get(name);
+  reopened.insertTuple({{0, "Hello", 3.14}});
+  EXPECT_EQ(reopened.getNumPages(), pages + 1);
+  EXPECT_EQ(reopened.getReads().size(), 1);
+  db.remove(name);
+}
+
+TEST(HeapFileTest, BulkLoad) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+  constexpr size_t capacity = 53;
+
+  // The empty page of a new file is replaced, and the pages are written without the pool
+  std::vector<db::Tuple> tuples;
+  for (int i = 0; i < capacity * 3 + 5; ++i) {
+    tuples.push_back({{i, "Hello", 3.14}});
+  }
+  file.bulkLoad(tuples);
+  EXPECT_EQ(file.getNumPages(), 4);
+  EXPECT_EQ(file.getIoStats().pages_written, 4);
+  EXPECT_FALSE(db.getBufferPool().contains({name, 3}));
+
+  // A loader appends after the existing pages, and inserts still fill the free slots of the partial page before them
+  {
+    db::HeapLoader loader(file, 2);
+    for (int i = capacity * 3 + 5; i < capacity * 8; ++i) {
+      loader.append({{i, "Hello", 3.14}});
+    }
+    EXPECT_EQ(loader.size(), capacity * 5 - 5);
+    EXPECT_THROW(loader.append({{0}}), std::runtime_error);
+  }
+  EXPECT_EQ(file.getNumPages(), 9);
+  file.insertTuple({{-1, "Hello", 3.14}});
+  EXPECT_EQ(file.getNumPages(), 9);
+
+  int i = 0;
+  bool found = false;
+  for (const auto &t : file) {
+    int id = std::get<int>(t.get_field(0));
+    if (id == -1) {
+      EXPECT_EQ(i, capacity * 3 + 5);
+      found = true;
+      continue;
+    }
+    EXPECT_EQ(id, i);
+    i++;
+  }
+  EXPECT_TRUE(found);
+  EXPECT_EQ(i, capacity * 8);
+  db.remove(name);
+}
+
+TEST(HeapFileTest, TupleView) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  for (int i = 0; i < capacity * 3; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+
+  int i = 0;
+  for (auto it = file.begin(); it != file.end(); ++it) {
+    db::TupleView view = it.view();
+    EXPECT_EQ(view.get_int(0), i);
+    EXPECT_EQ(view.get_char(1), "Hello");
+    i++;
+  }
+  EXPECT_EQ(i, capacity * 3);
+
+  // An iterator moved to another page pins it for the view
+  auto it = file.begin();
+  it.page = 2;
+  it.slot = 1;
+  EXPECT_EQ(it.view().get_int(0), capacity * 2 + 1);
+  EXPECT_EQ(it.guard.getPageId().page, 2);
+}
+
+TEST(HeapFileTest, BatchScan) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  for (int i = 0; i < capacity * 4; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+  // Leave page 1 empty and every other tuple of page 2
+  for (size_t slot = 0; slot < capacity; slot++) {
+    file.deleteTuple({file, 1, slot});
+    if (slot % 2 == 1) {
+      file.deleteTuple({file, 2, slot});
+    }
+  }
+
+  std::vector<int> ids;
+  std::vector<size_t> sizes;
+  db::PageBatch batch;
+  for (auto it = file.begin(); file.nextBatch(it, batch, 20);) {
+    EXPECT_TRUE(batch.page);
+    sizes.push_back(batch.size());
+    for (size_t row = 0; row < batch.size(); row++) {
+      ids.push_back(batch.view(row).get_int(0));
+    }
+  }
+  EXPECT_FALSE(batch.page);
+  EXPECT_EQ(sizes, (std::vector<size_t>{20, 20, 13, 20, 7, 20, 20, 13}));
+  std::vector<int> expected;
+  for (int i = 0; i < capacity * 4; ++i) {
+    if (i / capacity != 1 && (i / capacity != 2 || i % capacity % 2 == 0)) {
+      expected.push_back(i);
+    }
+  }
+  EXPECT_EQ(ids, expected);
+
+  // Without a limit, a batch is the rest of a page
+  auto it = file.begin();
+  ++it;
+  ASSERT_TRUE(file.nextBatch(it, batch));
+  EXPECT_EQ(batch.size(), capacity - 1);
+  ASSERT_TRUE(file.nextBatch(it, batch));
+  EXPECT_EQ(batch.page.getPageId().page, 2);
+}
+
+TEST(HeapFileTest, Pax) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove("heapfile.fsm");
+  db.add(std::make_unique<db::HeapFile>(name, td, db::PageLayout::PAX));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  for (int i = 0; i < capacity * 2; ++i) {
+    file.insertTuple({{i, "Hello" + std::to_string(i), i * 0.5}});
+  }
+  file.deleteTuple({file, 0, 7});
+  file.insertTuple({{-1, "again", -0.5}});
+
+  int i = 0;
+  for (auto it = file.begin(); it != file.end(); ++it, ++i) {
+    int id = i == 7 ? -1 : i;
+    db::Tuple t = *it;
+    EXPECT_EQ(t.get_field(0), db::field_t(id));
+    EXPECT_EQ(it.view().get_int(0), id);
+    if (i != 7) {
+      EXPECT_EQ(t.get_field(1), db::field_t("Hello" + std::to_string(i)));
+      EXPECT_EQ(it.view().get_char(1), "Hello" + std::to_string(i));
+      EXPECT_EQ(it.view().get_double(2), i * 0.5);
+    }
+  }
+  EXPECT_EQ(i, capacity * 2);
+
+  // The columns of a PAX page are contiguous
+  db::PageBatch batch;
+  auto it = file.begin();
+  ASSERT_TRUE(file.nextBatch(it, batch));
+  EXPECT_EQ(batch.size(), capacity);
+  EXPECT_EQ(batch.columnStride(0), db::INT_SIZE);
+  EXPECT_EQ(batch.columnStride(2), db::DOUBLE_SIZE);
+  int id;
+  std::memcpy(&id, batch.column(0) + 2 * db::INT_SIZE, sizeof(id));
+  EXPECT_EQ(id, 2);
+}
+
+TEST(HeapFileTest, ProjectedScan) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove("heapfile.fsm");
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  for (int i = 0; i < 100; ++i) {
+    file.insertTuple({{i, "Hello", i * 0.5}});
+  }
+
+  int i = 0;
+  for (auto it = file.scan({2, 0}); it != file.end(); ++it, ++i) {
+    db::Tuple t = *it;
+    ASSERT_EQ(t.size(), 2);
+    EXPECT_EQ(std::get<double>(t.get_field(0)), i * 0.5);
+    EXPECT_EQ(std::get<int>(t.get_field(1)), i);
+    // Views still see the whole tuple
+    EXPECT_EQ(it.view().get_char(1), "Hello");
+  }
+  EXPECT_EQ(i, 100);
+  EXPECT_THROW(file.scan({3}), std::out_of_range);
+}
+
+TEST(HeapFileTest, InsertRow) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove("heapfile.fsm");
+  db.add(std::make_unique<db::HeapFile>(name, td, db::PageLayout::PAX));
+  auto &file = db.get(name);
+  std::vector<uint8_t> row(td.length());
+  for (int i = 0; i < 100; ++i) {
+    td.serialize(row.data(), {{i, "Hello", i * 0.5}});
+    file.insertRow(row.data());
+  }
+
+  int i = 0;
+  for (auto it = file.begin(); it != file.end(); ++it, ++i) {
+    db::Tuple t = *it;
+    EXPECT_EQ(std::get<int>(t.get_field(0)), i);
+    EXPECT_EQ(std::get<db::string_t>(t.get_field(1)), "Hello");
+    EXPECT_EQ(std::get<double>(t.get_field(2)), i * 0.5);
+  }
+  EXPECT_EQ(i, 100);
+}
+
+TEST(HeapFileTest, Varchar) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  db::TupleDesc td({db::type_t::INT, db::type_t::VARCHAR}, {"id", "name"});
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove("heapfile.fsm");
+  EXPECT_THROW(db::HeapFile(name, td, db::PageLayout::PAX), std::logic_error);
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = dynamic_cast<db::HeapFile &>(db.get(name));
+  EXPECT_EQ(file.getLayout(), db::PageLayout::SLOTTED);
+  auto text = [](int i) { return std::string(i % 50, 'a' + i % 26); };
+  for (int i = 0; i < 1000; ++i) {
+    file.insertTuple({{i, text(i)}});
+  }
+  // Records of about 30 bytes: a CHAR column would need 1000 / 60 pages
+  EXPECT_LT(file.getNumPages(), 17);
+
+  // A short record may go to an earlier page than a longer one inserted before it
+  std::vector<int> ids;
+  for (auto it = file.begin(); it != file.end(); ++it) {
+    db::Tuple t = *it;
+    int id = std::get<int>(t.get_field(0));
+    EXPECT_EQ(std::get<db::string_t>(t.get_field(1)), text(id));
+    EXPECT_EQ(it.view().get_char(1), text(id));
+    ids.push_back(id);
+  }
+  std::sort(ids.begin(), ids.end());
+  std::vector<int> expected(1000);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(ids, expected);
+
+  // The space of deleted records is reused
+  size_t pages = file.getNumPages();
+  for (size_t slot = 0; slot < 20; slot++) {
+    file.deleteTuple({file, 0, slot});
+  }
+  file.insertTuple({{-1, std::string(200, 'z')}});
+  EXPECT_EQ(file.getNumPages(), pages);
+  EXPECT_EQ(std::get<int>(file.begin().operator*().get_field(0)), -1);
+
+  db::PageBatch batch;
+  size_t rows = 0;
+  for (auto it = file.begin(); file.nextBatch(it, batch);) {
+    for (size_t row = 0; row < batch.size(); row++) {
+      int id;
+      std::memcpy(&id, batch.field(0, row), sizeof(id));
+      EXPECT_EQ(id, batch.view(row).get_int(0));
+      rows++;
+    }
+  }
+  EXPECT_EQ(rows, 981);
+  EXPECT_THROW(file.insertTuple({{0, std::string(db::DEFAULT_PAGE_SIZE, 'x')}}), std::runtime_error);
+  // The page the record was tried on is not left in the pool past the end of the file
+  EXPECT_FALSE(db.getBufferPool().contains({name, file.getNumPages()}));
+}
+
+TEST(HeapFileTest, Nulls) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names, {false, true, true});
+  for (db::PageLayout layout : {db::PageLayout::ROW, db::PageLayout::PAX, db::PageLayout::SLOTTED}) {
+    std::string name = "heapfile" + std::to_string(static_cast<int>(layout));
+    std::remove(name.c_str());
+    std::remove((name + ".fsm").c_str());
+    db.add(std::make_unique<db::HeapFile>(name, td, layout));
+    auto &file = db.get(name);
+    for (int i = 0; i < 100; ++i) {
+      db::field_t price = i % 3 == 0 ? db::field_t(db::null_t{}) : db::field_t(i * 0.5);
+      file.insertTuple({{i, "Hello", price}});
+    }
+    EXPECT_THROW(file.insertTuple({{db::null_t{}, "Hello", 0.5}}), std::runtime_error);
+
+    int i = 0;
+    for (auto it = file.begin(); it != file.end(); ++it, ++i) {
+      db::Tuple t = *it;
+      EXPECT_EQ(t.get_field(0), db::field_t(i));
+      EXPECT_FALSE(it.view().is_null(1));
+      EXPECT_EQ(it.view().is_null(2), i % 3 == 0);
+      EXPECT_EQ(t.is_null(2), i % 3 == 0);
+    }
+    EXPECT_EQ(i, 100);
+  }
+}
+
+TEST(HeapFileTest, VarcharDeleteScan) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  db::TupleDesc td({db::type_t::INT, db::type_t::VARCHAR}, {"id", "name"});
+  const char *name = "heapfile";
+  std::remove(name);
+  std::remove("heapfile.fsm");
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  for (int i = 0; i < 1000; ++i) {
+    file.insertTuple({{i, std::string(i % 50, 'x')}});
+  }
+
+  // Deleting the last records of a page shrinks its directory under the scan
+  size_t deleted = 0;
+  for (auto it = file.begin(); it != file.end(); ++it, ++deleted) {
+    file.deleteTuple(it);
+  }
+  EXPECT_EQ(deleted, 1000);
+  EXPECT_EQ(file.begin(), file.end());
+
+  for (int i = 0; i < 1000; ++i) {
+    file.insertTuple({{i, std::string(i % 50, 'x')}});
+  }
+  deleted = 0;
+  db::PageBatch batch;
+  for (auto it = file.begin(); file.nextBatch(it, batch, 7);) {
+    size_t page = batch.page.getPageId().page;
+    std::vector<size_t> slots = batch.slots;
+    batch.clear();
+    for (size_t slot : slots) {
+      file.deleteTuple({file, page, slot});
+      deleted++;
+    }
+  }
+  EXPECT_EQ(deleted, 1000);
+  EXPECT_EQ(file.begin(), file.end());
+}
+
+TEST(HeapFileTest, FreeSpaceClasses) {
+  // A class never overstates the room of a page
+  EXPECT_EQ(db::FreeSpaceMap::classify(1, 4092), db::FreeSpaceMap::FULL);
+  EXPECT_EQ(db::FreeSpaceMap::classify(4092, 4092), db::FreeSpaceMap::EMPTY);
+  for (size_t length = 0; length < 4000; length += 7) {
+    uint8_t cls = db::HeapPage::requiredClass(length);
+    size_t free = (cls * size_t{4092} + 254) / 255;
+    EXPECT_GE(db::FreeSpaceMap::classify(free, 4092), cls);
+    EXPECT_LT(db::FreeSpaceMap::classify(length + 3, 4092), cls);
+  }
+
+  db::FreeSpaceMap map;
+  map.set(0, 10);
+  map.set(1, 200);
+  map.set(2, 10);
+  map.set(3, 255);
+  EXPECT_EQ(map.find(100), 1);
+  EXPECT_EQ(map.find(100, 2), 3);
+  EXPECT_EQ(map.find(5), 0);
+  map.set(1, 5);
+  EXPECT_EQ(map.find(100), 3);
+  EXPECT_EQ(map.find(201), 3);
+  // Space freed before the cursor of a class is found again
+  map.set(0, 255);
+  EXPECT_EQ(map.find(100), 0);
+  map.set(0, db::FreeSpaceMap::FULL);
+  map.set(3, db::FreeSpaceMap::FULL);
+  EXPECT_EQ(map.find(100), db::FreeSpaceMap::npos);
+  EXPECT_EQ(map.find(1), 1);
+}
+
+TEST(HeapFileTest, SkipEmptyPages) {
+  db::Database &db = db::getDatabase();
+  db.configureBufferPool({});
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  const char *name = "heapfile.skip";
+  std::remove(name);
+  std::remove("heapfile.skip.fsm");
+  db.add(std::make_unique<db::HeapFile>(name, td));
+  auto &file = db.get(name);
+  constexpr size_t capacity = 53;
+  constexpr size_t pages = 4;
+  for (int i = 0; i < capacity * pages; ++i) {
+    file.insertTuple({{i, "Hello", 3.14}});
+  }
+  for (size_t page : {1, 3}) {
+    for (size_t slot = 0; slot < capacity; slot++) {
+      file.deleteTuple({file, page, slot});
+    }
+  }
+  db.getBufferPool().flushFile(name);
+  db.configureBufferPool({});
+
+  // The empty pages are known from the free space map, so a scan does not read them
+  file.setTraceCapacity(pages);
+  size_t count = 0;
+  for (const auto &t : file) {
+    EXPECT_LT(std::get<int>(t.get_field(0)) / capacity % 2, 1);
+    count++;
+  }
+  EXPECT_EQ(count, capacity * 2);
+  EXPECT_EQ(file.getReads().retained(), (std::vector<size_t>{0, 2}));
+
+  db::PageBatch batch;
+  count = 0;
+  for (auto it = file.begin(); file.nextBatch(it, batch, 20);) {
+    EXPECT_NE(batch.page.getPageId().page % 2, 1);
+    count += batch.size();
+  }
+  EXPECT_EQ(count, capacity * 2);
+  db.remove(name);
+}
@@ -105,3 +105,212 @@ TEST(TupleTest, MergeConflict) {
 
   EXPECT_ANY_THROW(db::TupleDesc::merge(td1, td2));  // Non-unique names
 }
+
+TEST(TupleTest, View) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  std::vector<uint8_t> data(td.length());
+  db::Tuple t({660, std::string(db::CHAR_SIZE, 'x'), 2.5});
+  td.serialize(data.data(), t);
+
+  db::TupleView view(td, data.data());
+  EXPECT_EQ(view.size(), 3);
+  EXPECT_EQ(view.field_type(1), db::type_t::CHAR);
+  EXPECT_EQ(view.get_int(0), 660);
+  // A string that fills the field has no terminator
+  EXPECT_EQ(view.get_char(1), std::string(db::CHAR_SIZE, 'x'));
+  // The field after it starts with a nonzero byte, which is not part of the string
+  td.serialize(data.data(), {{660, std::string(db::CHAR_SIZE, 'x'), 0.1}});
+  EXPECT_EQ(td.deserialize(data.data()).get_field(1), view.get_field(1));
+  td.serialize(data.data(), t);
+  EXPECT_EQ(view.get_double(2), 2.5);
+  EXPECT_EQ(view.get_field(0), t.get_field(0));
+  EXPECT_THROW(view.get_int(2), std::logic_error);
+  EXPECT_THROW(view.get_char(0), std::logic_error);
+
+  td.serialize(data.data(), {{-1, "short", 0.0}});
+  db::Tuple materialized = view.materialize();
+  EXPECT_EQ(std::get<int>(materialized.get_field(0)), -1);
+  EXPECT_EQ(std::get<db::string_t>(materialized.get_field(1)), "short");
+  EXPECT_EQ(view.get_char(1), "short");
+}
+
+TEST(TupleTest, DeserializeProjection) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  std::vector<uint8_t> data(td.length());
+  td.serialize(data.data(), {{660, "db", 2.5}});
+
+  db::Tuple t = td.deserialize(data.data(), {2, 0});
+  EXPECT_EQ(t.size(), 2);
+  EXPECT_EQ(std::get<double>(t.get_field(0)), 2.5);
+  EXPECT_EQ(std::get<int>(t.get_field(1)), 660);
+  EXPECT_EQ(td.deserialize(data.data(), {}).size(), 0);
+  EXPECT_EQ(db::TupleView(td, data.data()).materialize({1}).get_field(0), db::field_t("db"));
+  EXPECT_THROW(td.deserialize(data.data(), {3}), std::out_of_range);
+}
+
+TEST(TupleTest, ViewSerialize) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names);
+  std::vector<uint8_t> data(td.length());
+  td.serialize(data.data(), {{660, "db", 2.5}});
+  db::TupleView view(td, data.data());
+
+  std::vector<uint8_t> row(td.length());
+  view.serialize(row.data());
+  EXPECT_EQ(row, data);
+
+  db::TupleDesc projected({db::type_t::DOUBLE, db::type_t::CHAR}, {"price", "name"});
+  std::vector<uint8_t> projected_row(projected.length());
+  view.serialize(projected_row.data(), {2, 1});
+  db::Tuple t = projected.deserialize(projected_row.data());
+  EXPECT_EQ(std::get<double>(t.get_field(0)), 2.5);
+  EXPECT_EQ(std::get<db::string_t>(t.get_field(1)), "db");
+}
+
+TEST(TupleTest, Varchar) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::VARCHAR, db::type_t::VARCHAR};
+  std::vector<std::string> names{"id", "code", "text"};
+  db::TupleDesc td(types, names);
+  EXPECT_FALSE(td.is_fixed());
+  EXPECT_TRUE(db::TupleDesc({db::type_t::INT}, {"id"}).is_fixed());
+  EXPECT_EQ(td.length(), db::INT_SIZE + 2 * db::VARCHAR_SIZE);
+
+  db::Tuple t({660, "db", std::string(100, 'x')});
+  EXPECT_TRUE(td.compatible(t));
+  EXPECT_EQ(td.length(t), td.length() + 2 + 2 + 2 + 100);
+  std::vector<uint8_t> data(td.length(t));
+  td.serialize(data.data(), t);
+  EXPECT_EQ(td.length(data.data()), data.size());
+
+  db::Tuple read = td.deserialize(data.data());
+  EXPECT_EQ(std::get<int>(read.get_field(0)), 660);
+  EXPECT_EQ(std::get<db::string_t>(read.get_field(1)), "db");
+  EXPECT_EQ(std::get<db::string_t>(read.get_field(2)), std::string(100, 'x'));
+  EXPECT_EQ(td.deserialize(data.data(), {2}).get_field(0), db::field_t(std::string(100, 'x')));
+
+  db::TupleView view(td, data.data());
+  EXPECT_EQ(view.get_char(1), "db");
+  EXPECT_THROW(view.get_int(1), std::logic_error);
+
+  // A projected row has its own VARCHAR offsets
+  db::TupleDesc projected({db::type_t::VARCHAR, db::type_t::INT}, {"code", "id"});
+  std::vector<uint8_t> projected_row(projected.length() + 2 + 2);
+  view.serialize(projected_row.data(), {1, 0});
+  db::Tuple p = projected.deserialize(projected_row.data());
+  EXPECT_EQ(std::get<db::string_t>(p.get_field(0)), "db");
+  EXPECT_EQ(std::get<int>(p.get_field(1)), 660);
+
+  EXPECT_THROW(td.serialize(data.data(), {{0, "", std::string(UINT16_MAX, 'x')}}), std::length_error);
+}
+
+TEST(TupleTest, WideTypes) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::INT64, db::type_t::TIMESTAMP, db::type_t::DECIMAL};
+  std::vector<std::string> names{"id", "big", "at", "price"};
+  db::TupleDesc td(types, names);
+  EXPECT_TRUE(td.is_fixed());
+  EXPECT_EQ(td.length(), db::INT_SIZE + db::INT64_SIZE + db::TIMESTAMP_SIZE + db::DECIMAL_SIZE);
+  EXPECT_EQ(td.offset_of(3), db::INT_SIZE + db::INT64_SIZE + db::TIMESTAMP_SIZE);
+
+  int64_t big = int64_t{1} << 40;
+  db::Tuple t({1, big, db::timestamp_t{1'700'000'000'000'000}, db::decimal_t{-12'3456}});
+  EXPECT_TRUE(td.compatible(t));
+  EXPECT_FALSE(td.compatible({{1, 2, db::timestamp_t{}, db::decimal_t{}}}));
+  std::vector<uint8_t> data(td.length());
+  td.serialize(data.data(), t);
+
+  db::Tuple read = td.deserialize(data.data());
+  EXPECT_EQ(std::get<int64_t>(read.get_field(1)), big);
+  EXPECT_EQ(std::get<db::timestamp_t>(read.get_field(2)).micros, 1'700'000'000'000'000);
+  EXPECT_EQ(std::get<db::decimal_t>(read.get_field(3)).units, -12'3456);
+  EXPECT_EQ(td.deserialize(data.data(), {3}).get_field(0), db::field_t(db::decimal_t{-12'3456}));
+
+  db::TupleView view(td, data.data());
+  EXPECT_EQ(view.get_int64(1), big);
+  EXPECT_EQ(view.get_timestamp(2), db::timestamp_t{1'700'000'000'000'000});
+  EXPECT_EQ(view.get_decimal(3), db::decimal_t{-12'3456});
+  EXPECT_EQ(view.get_field(1), db::field_t(big));
+  EXPECT_THROW(view.get_int64(2), std::logic_error);
+  EXPECT_THROW(view.get_int(1), std::logic_error);
+}
+
+TEST(TupleTest, Nulls) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::DOUBLE, db::type_t::VARCHAR};
+  std::vector<std::string> names{"id", "price", "text"};
+  db::TupleDesc td(types, names, {false, true, true});
+  EXPECT_TRUE(td.is_nullable(1));
+  EXPECT_FALSE(td.is_nullable(0));
+  EXPECT_EQ(td.bitmap_length(), 1);
+  EXPECT_EQ(td.offset_of(0), 1);
+  EXPECT_EQ(db::TupleDesc(types, names).bitmap_length(), 0);
+  EXPECT_THROW(db::TupleDesc(types, names, {true}), std::logic_error);
+
+  db::Tuple t({660, db::null_t{}, db::null_t{}});
+  EXPECT_TRUE(td.compatible(t));
+  EXPECT_FALSE(td.compatible({{db::null_t{}, 1.0, "x"}}));
+  EXPECT_THROW(t.field_type(1), std::logic_error);
+  std::vector<uint8_t> data(td.length(t));
+  td.serialize(data.data(), t);
+  EXPECT_EQ(td.length(data.data()), data.size());
+
+  db::Tuple read = td.deserialize(data.data());
+  EXPECT_EQ(read.get_field(0), db::field_t(660));
+  EXPECT_TRUE(read.is_null(1));
+  EXPECT_TRUE(read.is_null(2));
+  EXPECT_TRUE(td.deserialize(data.data(), {2, 0}).is_null(0));
+
+  db::TupleView view(td, data.data());
+  EXPECT_FALSE(view.is_null(0));
+  EXPECT_TRUE(view.is_null(1));
+  EXPECT_EQ(view.get_field(2), db::field_t(db::null_t{}));
+  EXPECT_EQ(view.get_double(1), 0.0);
+
+  // A projected row has its own null bitmap, if one of its fields is nullable
+  db::TupleDesc projected({db::type_t::INT, db::type_t::DOUBLE}, {"id", "price"}, {false, true});
+  std::vector<uint8_t> projected_row(projected.length());
+  view.serialize(projected_row.data(), {0, 1});
+  db::Tuple p = projected.deserialize(projected_row.data());
+  EXPECT_EQ(p.get_field(0), db::field_t(660));
+  EXPECT_TRUE(p.is_null(1));
+}
+
+TEST(TupleTest, StringField) {
+  db::string_t empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty, "");
+
+  // Values up to CHAR_SIZE characters are inline, longer ones on the heap
+  std::string full(db::CHAR_SIZE, 'x');
+  std::string longer(db::CHAR_SIZE + 1, 'y');
+  db::string_t a(full);
+  db::string_t b(longer);
+  EXPECT_EQ(a, full);
+  EXPECT_EQ(b.view(), longer);
+  EXPECT_LT(a, b);
+
+  db::string_t c = b;
+  db::string_t d = std::move(c);
+  EXPECT_TRUE(c.empty());
+  EXPECT_EQ(d, longer);
+  d = a;
+  EXPECT_EQ(d, full);
+  d = b;
+  d = d;
+  EXPECT_EQ(d, b);
+  c = std::move(d);
+  EXPECT_EQ(c, longer);
+
+  // A CHAR field keeps the first CHAR_SIZE characters of a longer value
+  db::TupleDesc td({db::type_t::CHAR, db::type_t::VARCHAR}, {"name", "text"});
+  db::Tuple t({longer, longer});
+  EXPECT_EQ(t.field_type(0), db::type_t::CHAR);
+  std::vector<uint8_t> data(td.length(t));
+  td.serialize(data.data(), t);
+  db::Tuple read = td.deserialize(data.data());
+  EXPECT_EQ(std::get<db::string_t>(read.get_field(0)), longer.substr(0, db::CHAR_SIZE));
+  EXPECT_EQ(read.get_field(1), db::field_t(longer));
+}
@@ -24,7 +24,7 @@ TEST(BTreeTest, Sorted) {
   int i = 0;
   for (const auto &t : file) {
     EXPECT_EQ(std::get<int>(t.get_field(0)), i);
-    EXPECT_EQ(std::get<std::string>(t.get_field(1)), "apple");
+    EXPECT_EQ(std::get<db::string_t>(t.get_field(1)), "apple");
     EXPECT_EQ(std::get<double>(t.get_field(2)), 1.0);
     i++;
   }
@@ -45,7 +45,7 @@ TEST(BTreeTest, Random) {
   int i = 0;
   for (const auto &t : file) {
     EXPECT_EQ(std::get<int>(t.get_field(0)), i);
-    EXPECT_EQ(std::get<std::string>(t.get_field(1)), "apple");
+    EXPECT_EQ(std::get<db::string_t>(t.get_field(1)), "apple");
     EXPECT_EQ(std::get<double>(t.get_field(2)), 1.0);
     i++;
   }
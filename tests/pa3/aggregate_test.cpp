@@ -270,3 +270,92 @@ TEST(AggregateTest, Grouped) {
   ++it;
   EXPECT_EQ(it, out.end());
 }
+
+TEST(AggregateTest, Wide) {
+  std::vector<db::type_t> types1{db::type_t::INT64, db::type_t::TIMESTAMP, db::type_t::DECIMAL};
+  std::vector<std::string> names1{"id", "at", "price"};
+  db::TupleDesc td1(types1, names1);
+
+  const char *in_name = "heapfile.in";
+  std::remove(in_name);
+  db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td1));
+  auto &in = db::getDatabase().get(in_name);
+
+  constexpr int64_t base = int64_t{1} << 40;
+  for (int64_t i = 1; i <= 1000; ++i) {
+    in.insertTuple({{base * i, db::timestamp_t{-i}, db::decimal_t{i * 1'2500}}});
+  }
+
+  std::vector<std::pair<db::Aggregate, db::field_t>> cases{
+      {{std::nullopt, db::AggregateOp::MAX, "id"}, base * 1000},
+      {{std::nullopt, db::AggregateOp::SUM, "id"}, base * 500500},
+      {{std::nullopt, db::AggregateOp::MIN, "at"}, db::timestamp_t{-1000}},
+      {{std::nullopt, db::AggregateOp::SUM, "price"}, db::decimal_t{int64_t{500500} * 1'2500}},
+      {{std::nullopt, db::AggregateOp::AVG, "price"}, 500.5 * 1.25},
+      {{std::nullopt, db::AggregateOp::COUNT, "at"}, 1000},
+  };
+  for (size_t k = 0; k < cases.size(); ++k) {
+    const auto &[agg, expected] = cases[k];
+    std::string out_name = "heapfile.out" + std::to_string(k);
+    std::remove(out_name.c_str());
+    db::TupleDesc td2({db::Tuple({expected}).field_type(0)}, {"result"});
+    db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td2));
+    auto &out = db::getDatabase().get(out_name);
+    db::aggregate(in, out, agg);
+    auto it = out.begin();
+    EXPECT_NE(it, out.end());
+    EXPECT_EQ((*it).get_field(0), expected);
+  }
+
+  std::remove("heapfile.err");
+  db::getDatabase().add(std::make_unique<db::HeapFile>("heapfile.err", db::TupleDesc({db::type_t::TIMESTAMP}, {"r"})));
+  EXPECT_THROW(db::aggregate(in, db::getDatabase().get("heapfile.err"), {std::nullopt, db::AggregateOp::SUM, "at"}),
+               std::logic_error);
+}
+
+TEST(AggregateTest, Nulls) {
+  std::vector<db::type_t> types1{db::type_t::INT, db::type_t::INT};
+  std::vector<std::string> names1{"id", "score"};
+  db::TupleDesc td1(types1, names1, {false, true});
+
+  const char *in_name = "heapfile.in";
+  std::remove(in_name);
+  db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td1));
+  auto &in = db::getDatabase().get(in_name);
+
+  // The scores of 0, 10, ..., 90 are NULL, and would be the minimum if they were read
+  for (int i = 0; i < 100; ++i) {
+    in.insertTuple({{i, i % 10 == 0 ? db::field_t(db::null_t{}) : db::field_t(i)}});
+  }
+
+  std::vector<std::pair<db::Aggregate, db::field_t>> cases{
+      {{std::nullopt, db::AggregateOp::MIN, "score"}, 1},
+      {{std::nullopt, db::AggregateOp::COUNT, "score"}, 90},
+      {{std::nullopt, db::AggregateOp::COUNT, "id"}, 100},
+      {{std::nullopt, db::AggregateOp::SUM, "score"}, 4950 - 450},
+      {{std::nullopt, db::AggregateOp::AVG, "score"}, 4500 / 90.0},
+  };
+  for (size_t k = 0; k < cases.size(); ++k) {
+    const auto &[agg, expected] = cases[k];
+    std::string out_name = "heapfile.out" + std::to_string(k);
+    std::remove(out_name.c_str());
+    db::TupleDesc td2({db::Tuple({expected}).field_type(0)}, {"result"}, {true});
+    db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td2));
+    auto &out = db::getDatabase().get(out_name);
+    db::aggregate(in, out, agg);
+    auto it = out.begin();
+    EXPECT_NE(it, out.end());
+    EXPECT_EQ((*it).get_field(0), expected);
+  }
+
+  // Only NULL values have no minimum
+  std::remove("heapfile.nulls");
+  db::getDatabase().add(std::make_unique<db::HeapFile>("heapfile.nulls", td1));
+  auto &nulls = db::getDatabase().get("heapfile.nulls");
+  nulls.insertTuple({{0, db::null_t{}}});
+  std::remove("heapfile.min");
+  db::getDatabase().add(std::make_unique<db::HeapFile>("heapfile.min", db::TupleDesc({db::type_t::INT}, {"r"}, {true})));
+  auto &min = db::getDatabase().get("heapfile.min");
+  db::aggregate(nulls, min, {std::nullopt, db::AggregateOp::MIN, "score"});
+  EXPECT_TRUE((*min.begin()).is_null(0));
+}
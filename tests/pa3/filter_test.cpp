@@ -89,3 +89,68 @@ TEST(FilterTest, One) {
   }
   EXPECT_EQ(i, 31);
 }
+
+TEST(FilterTest, Wide) {
+  std::vector<db::type_t> types{db::type_t::INT64, db::type_t::TIMESTAMP, db::type_t::DECIMAL};
+  std::vector<std::string> names{"id", "at", "price"};
+  db::TupleDesc td(types, names);
+
+  const char *in_name = "heapfile.in";
+  const char *out_name = "heapfile.out";
+  std::remove(in_name);
+  std::remove(out_name);
+  db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td));
+  db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td));
+  auto &in = db::getDatabase().get(in_name);
+  auto &out = db::getDatabase().get(out_name);
+  constexpr int64_t base = int64_t{1} << 40;
+  for (int64_t i = 0; i < 300; ++i) {
+    in.insertTuple({{base + i, db::timestamp_t{i * 1'000'000}, db::decimal_t{i * 2'5000}}});
+  }
+
+  db::filter(in, out,
+             {{"id", db::PredicateOp::GE, base + 100},
+              {"at", db::PredicateOp::LT, db::timestamp_t{200'000'000}},
+              {"price", db::PredicateOp::NE, db::decimal_t{150 * 2'5000}}});
+
+  int64_t i = 100;
+  for (const auto &t : out) {
+    if (i == 150) {
+      ++i;
+    }
+    EXPECT_EQ(get<int64_t>(t.get_field(0)), base + i);
+    EXPECT_EQ(get<db::decimal_t>(t.get_field(2)).units, i * 2'5000);
+    ++i;
+  }
+  EXPECT_EQ(i, 200);
+}
+
+TEST(FilterTest, Nulls) {
+  std::vector<db::type_t> types{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};
+  std::vector<std::string> names{"id", "name", "price"};
+  db::TupleDesc td(types, names, {false, true, true});
+
+  const char *in_name = "heapfile.in";
+  const char *out_name = "heapfile.out";
+  std::remove(in_name);
+  std::remove(out_name);
+  db::getDatabase().add(std::make_unique<db::HeapFile>(in_name, td));
+  db::getDatabase().add(std::make_unique<db::HeapFile>(out_name, td));
+  auto &in = db::getDatabase().get(in_name);
+  auto &out = db::getDatabase().get(out_name);
+  for (int i = 0; i < 300; ++i) {
+    db::field_t price = i % 2 == 0 ? db::field_t(db::null_t{}) : db::field_t(1.0 * i);
+    in.insertTuple({{i, "Hello", price}});
+  }
+
+  // `price < 100` is unknown for a NULL price, so the row is dropped
+  db::filter(in, out, {{"price", db::PredicateOp::LT, 100.0}, {"name", db::PredicateOp::NE, "Bye"}});
+
+  int i = 1;
+  for (const auto &t : out) {
+    EXPECT_EQ(get<int>(t.get_field(0)), i);
+    EXPECT_FALSE(t.is_null(2));
+    i += 2;
+  }
+  EXPECT_EQ(i, 101);
+}
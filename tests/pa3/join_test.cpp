@@ -3,6 +3,7 @@
 #include <db/Query.hpp>
 #include <gtest/gtest.h>
 #include <random>
+#include <unordered_set>
 
 TEST(JoinTest, Small) {
   std::vector<db::type_t> types1{db::type_t::INT, db::type_t::CHAR, db::type_t::DOUBLE};